@@ -48,6 +48,38 @@ echo Test 11: Allocation Failure Test
 memsim.exe < tests\allocation_failure_test.txt > results\allocation_failure_result.txt
 echo - Allocation failure test completed
 
+echo Test 12: Compaction Test
+memsim.exe < tests\compaction_test.txt > results\compaction_result.txt
+echo - Compaction test completed
+
+echo Test 13: Access Pipeline Test
+memsim.exe < tests\access_pipeline_test.txt > results\access_pipeline_result.txt
+echo - Access pipeline test completed
+
+echo Test 14: Prefetcher Test
+memsim.exe < tests\prefetch_test.txt > results\prefetch_result.txt
+echo - Prefetcher test completed
+
+echo Test 15: Page Replacement Test
+memsim.exe < tests\page_replacement_test.txt > results\page_replacement_result.txt
+echo - Page replacement test completed
+
+echo Test 16: Huge Page Test
+memsim.exe < tests\huge_page_test.txt > results\huge_page_result.txt
+echo - Huge page test completed
+
+echo Test 17: Multi-arena Allocator Test
+memsim.exe < tests\arena_test.txt > results\arena_result.txt
+echo - Multi-arena allocator test completed
+
+echo Test 18: NUMA Test
+memsim.exe < tests\numa_test.txt > results\numa_result.txt
+echo - NUMA test completed
+
+echo Test 19: Trace Import Test
+memsim.exe < tests\trace_import_test.txt > results\trace_import_result.txt
+echo - Trace import test completed
+
 echo.
 echo All tests completed! Check results\ directory for outputs.
 echo Run validate_results.py to check test correctness.
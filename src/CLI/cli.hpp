@@ -1,8 +1,12 @@
 #include <iostream>
 #include "../cache/cache.hpp"
 #include "../virtual memory/virtual.hpp"
+#include "../pipeline/pipeline.hpp"
+#include "../allocator/arena.hpp"
+#include "../trace/trace.hpp"
 #include <vector>
 #include <string>
+#include <fstream>
 using namespace std ;
 
 struct cli{
@@ -34,6 +38,74 @@ struct cli{
 
     }
 
+    int policy_code( string name ){
+        vector < string > names = { "lru" , "fifo" , "clock" , "second" , "wsclock" , "aging" , "opt" } ;
+        for( int i = 0 ; i < (int)names.size() ; i++ ){
+            if( names[ i ] == name ) return i ;
+        }
+        return -1 ;
+    }
+
+    // Replays a file of virtual addresses against a fresh copy of the virtual
+    // memory configuration for each requested policy and reports the faults
+    void replay( virtual_memory* vmem , string policy , string file ){
+
+        ifstream in( file ) ;
+        if( !in ){
+            cout << "Could not open trace " << file << endl ;
+            return ;
+        }
+
+        vector < int > addresses ;
+        int skipped = 0 ;
+        string token ;
+        while( in >> token ){
+            if( token[ 0 ] == '#' ){
+                getline( in , token ) ;
+                continue ;
+            }
+            int address = stoi( token ) ;
+            if( address < 0 || address >= vmem->vmem_size ) skipped++ ;
+            else addresses.push_back( address ) ;
+        }
+        cout << "Replaying " << addresses.size() << " accesses from " << file ;
+        if( skipped > 0 ) cout << " (" << skipped << " out of range skipped)" ;
+        cout << endl ;
+
+        vector < int > policies ;
+        if( policy == "all" ){
+            for( int i = 0 ; i <= 6 ; i++ ) policies.push_back( i ) ;
+        }
+        else{
+            policies.push_back( policy_code( policy ) ) ;
+        }
+
+        int lru_faults = -1 ;
+        int opt_faults = -1 ;
+        for( int p : policies ){
+            virtual_memory vm( vmem->vmem_size , vmem->pmem_size , vmem->page_size ) ;
+            vm.working_set_window = vmem->working_set_window ;
+            vm.aging_interval = vmem->aging_interval ;
+            vm.huge_spans = vmem->huge_spans ;
+            vm.thp_mode = vmem->thp_mode ;
+            vm.promote_threshold = vmem->promote_threshold ;
+            vm.set_policy( p ) ;
+            if( p == 6 ) vm.load_trace( addresses ) ;
+            for( int address : addresses ) vm.translate( address ) ;
+
+            cout << "Policy: " << vm.policy_name() << ", Accesses: " << vm.translations
+                 << ", Page Faults: " << vm.page_faults << ", Fault Rate: " << vm.fault_rate() << endl ;
+            if( p == 0 ) lru_faults = vm.page_faults ;
+            if( p == 6 ) opt_faults = vm.page_faults ;
+        }
+
+        if( lru_faults != -1 && opt_faults > 0 ){
+            cout << "LRU faults over OPT: " << lru_faults - opt_faults << " ("
+                 << ( (double)( lru_faults - opt_faults ) / opt_faults ) * 100 << "%)" << endl ;
+        }
+
+    }
+
     void run(){
         string cmd ;
         cout << "Memory Management Simulator" << endl ;
@@ -45,6 +117,8 @@ struct cli{
         cachelevel* l1_cache = NULL ;
         cachelevel* l2_cache = NULL ;
         virtual_memory* vmem = NULL ;
+        numa_topology* numa = NULL ;
+        access_pipeline pipeline ;
 
         while( getline( cin , cmd ) ){
             
@@ -72,6 +146,131 @@ struct cli{
                     cout << "Usage: init memory <size>" << endl ;
                 }
             }
+            if( split[ 0 ] == "set" && split.size() >= 3 && split[ 1 ] == "compaction" ){
+                if( memory == NULL ){
+                    cout << "Memory not initialized. Use 'init memory <size>' first" << endl ;
+                } else if( split[ 2 ] == "on" || split[ 2 ] == "off" ){
+                    memory->auto_compact = ( split[ 2 ] == "on" ) ;
+                    cout << "Auto compaction " << split[ 2 ] << endl ;
+                } else {
+                    cout << "Usage: set compaction <on|off>" << endl ;
+                }
+                cout << "> " ;
+                continue ;
+            }
+            if( split[ 0 ] == "set" && split.size() >= 2 && split[ 1 ] == "latency" ){
+                if( split.size() >= 4 && stoi( split[ 3 ] ) < 0 ){
+                    cout << "Latency cannot be negative" << endl ;
+                } else if( split.size() >= 4 && pipeline.set_latency( split[ 2 ] , stoi( split[ 3 ] ) ) ){
+                    cout << "Latency of " << split[ 2 ] << " set to " << split[ 3 ] << " cycles" << endl ;
+                } else {
+                    cout << "Usage: set latency <l1|l2|memory|fault|migrate> <cycles>" << endl ;
+                }
+                cout << "> " ;
+                continue ;
+            }
+            if( split[ 0 ] == "set" && split.size() >= 2 && split[ 1 ] == "prefetcher" ){
+                cachelevel* level = NULL ;
+                if( split.size() >= 4 && split[ 2 ] == "1" ) level = l1_cache ;
+                if( split.size() >= 4 && split[ 2 ] == "2" ) level = l2_cache ;
+                int kind = -1 ;
+                if( split.size() >= 4 ){
+                    if( split[ 3 ] == "none" ) kind = 0 ;
+                    else if( split[ 3 ] == "next" ) kind = 1 ;
+                    else if( split[ 3 ] == "stride" ) kind = 2 ;
+                    else if( split[ 3 ] == "stream" ) kind = 3 ;
+                }
+                if( kind == -1 ){
+                    cout << "Usage: set prefetcher <1|2> <none|next|stride|stream> [degree] [delay]" << endl ;
+                } else if( level == NULL ){
+                    cout << "Cache L" << split[ 2 ] << " not initialized" << endl ;
+                } else if( split.size() >= 5 && ( stoi( split[ 4 ] ) < 1 || stoi( split[ 4 ] ) > level->sets * level->associativity ) ){
+                    // Prefetching more lines than the cache holds only evicts its own fills
+                    cout << "Prefetch degree must be between 1 and " << level->sets * level->associativity << " (lines in the cache)" << endl ;
+                } else if( split.size() >= 6 && stoi( split[ 5 ] ) < 0 ){
+                    cout << "Prefetch delay cannot be negative" << endl ;
+                } else {
+                    level->prefetcher = kind ;
+                    if( split.size() >= 5 ) level->prefetch_degree = stoi( split[ 4 ] ) ;
+                    if( split.size() >= 6 ) level->prefetch_delay = stoi( split[ 5 ] ) ;
+                    cout << "L" << split[ 2 ] << " prefetcher set to " << level->prefetcher_name() << endl ;
+                }
+                cout << "> " ;
+                continue ;
+            }
+            if( split[ 0 ] == "set" && split.size() >= 2 && split[ 1 ] == "replacement" ){
+                int p = ( split.size() >= 3 ) ? policy_code( split[ 2 ] ) : -1 ;
+                if( p == -1 ){
+                    cout << "Usage: set replacement <lru|fifo|clock|second|wsclock|aging> [window]" << endl ;
+                } else if( p == 6 ){
+                    cout << "opt needs the future of the trace, use 'replay opt <file>'" << endl ;
+                } else if( vmem == NULL ){
+                    cout << "Virtual memory not initialized" << endl ;
+                } else if( split.size() >= 4 && ( p == 4 || p == 5 ) && stoi( split[ 3 ] ) <= 0 ){
+                    cout << "The " << ( p == 4 ? "window" : "interval" ) << " must be at least 1" << endl ;
+                } else {
+                    if( split.size() >= 4 && p == 4 ) vmem->working_set_window = stoi( split[ 3 ] ) ;
+                    if( split.size() >= 4 && p == 5 ) vmem->aging_interval = stoi( split[ 3 ] ) ;
+                    vmem->set_policy( p ) ;
+                    cout << "Page replacement set to " << vmem->policy_name() << endl ;
+                }
+                cout << "> " ;
+                continue ;
+            }
+            if( split[ 0 ] == "set" && split.size() >= 2 && split[ 1 ] == "hugepages" ){
+                if( vmem == NULL ){
+                    cout << "Virtual memory not initialized" << endl ;
+                } else if( split.size() == 3 && split[ 2 ] == "off" ){
+                    vmem->set_huge_pages( {} ) ;
+                    cout << "Huge pages disabled" << endl ;
+                } else if( split.size() >= 3 ){
+                    vector < int > sizes ;
+                    bool valid = true ;
+                    for( int i = 2 ; i < (int)split.size() ; i++ ){
+                        int size = stoi( split[ i ] ) ;
+                        int span = size / vmem->page_size ;
+                        if( size % vmem->page_size != 0 || span < 2 || ( span & ( span - 1 ) ) != 0 ){
+                            cout << "Huge page size " << size << " must be a power-of-two multiple of the page size" << endl ;
+                            valid = false ;
+                        } else if( span > vmem->num_frames ){
+                            cout << "Huge page size " << size << " is larger than physical memory" << endl ;
+                            valid = false ;
+                        } else {
+                            sizes.push_back( size ) ;
+                        }
+                    }
+                    if( valid ){
+                        vmem->set_huge_pages( sizes ) ;
+                        if( vmem->thp_mode == 0 ) vmem->thp_mode = 1 ;
+                        cout << "Huge page sizes set" << endl ;
+                    }
+                } else {
+                    cout << "Usage: set hugepages <size> [size ...] | set hugepages off" << endl ;
+                }
+                cout << "> " ;
+                continue ;
+            }
+            if( split[ 0 ] == "set" && split.size() >= 2 && split[ 1 ] == "thp" ){
+                int mode = -1 ;
+                if( split.size() >= 3 ){
+                    if( split[ 2 ] == "never" ) mode = 0 ;
+                    else if( split[ 2 ] == "promote" ) mode = 1 ;
+                    else if( split[ 2 ] == "always" ) mode = 2 ;
+                }
+                if( mode == -1 ){
+                    cout << "Usage: set thp <never|promote|always> [threshold%]" << endl ;
+                } else if( vmem == NULL ){
+                    cout << "Virtual memory not initialized" << endl ;
+                } else if( split.size() >= 4 && ( stoi( split[ 3 ] ) < 1 || stoi( split[ 3 ] ) > 100 ) ){
+                    cout << "Promotion threshold must be between 1 and 100 percent" << endl ;
+                } else {
+                    vmem->thp_mode = mode ;
+                    if( split.size() >= 4 ) vmem->promote_threshold = stoi( split[ 3 ] ) ;
+                    cout << "Transparent huge pages: " << split[ 2 ] << ", promotion threshold " << vmem->promote_threshold << "%" << endl ;
+                }
+                cout << "> " ;
+                continue ;
+            }
             if( split[ 0 ] == "set" ){
                 if( split.size() >= 3 ){
                     if( split[ 2 ][ 0 ] == 'f' ) allocator = 1 ;
@@ -90,6 +289,8 @@ struct cli{
             if( split[ 0 ] == "malloc" ){
                 if( memory == NULL ){
                     cout << "Memory not initialized. Use 'init memory <size>' first" << endl ;
+                } else if( split.size() >= 2 && stoi( split[ 1 ] ) <= 0 ){
+                    cout << "Allocation size must be positive" << endl ;
                 } else if( split.size() >= 2 ){
                     if( allocator == 1 ) memory->first_fit( stoi( split[ 1 ] ) ) ;
                     if( allocator == 2 ) memory->best_fit( stoi( split[ 1 ] ) ) ;
@@ -107,6 +308,21 @@ struct cli{
                     cout << "Usage: free <id>" << endl ;
                 }
             }
+            if( split[ 0 ] == "compact" ){
+                if( memory == NULL ){
+                    cout << "Memory not initialized" << endl ;
+                } else if( split.size() >= 3 && split[ 1 ] == "step" ){
+                    int moved = memory->compact_step( stoi( split[ 2 ] ) ) ;
+                    cout << "Compaction step moved " << moved << " units" << endl ;
+                    if( memory->is_compacted() ) cout << "Memory fully compacted" << endl ;
+                    else if( moved == 0 ) cout << "No movable block fits the budget, use a larger budget or 'compact'" << endl ;
+                } else if( split.size() == 1 ){
+                    int moved = memory->compact() ;
+                    cout << "Memory compacted, " << moved << " units moved" << endl ;
+                } else {
+                    cout << "Usage: compact [step <budget>]" << endl ;
+                }
+            }
             if( split[ 0 ] == "dump" ){
                 if( memory == NULL ){
                     cout << "Memory not initialized" << endl ;
@@ -122,33 +338,202 @@ struct cli{
                 }
             }
             
-            // Virtual Memory Commands
-            if( split[ 0 ] == "init" && split[ 1 ] == "virtual" ){
-                int vmem_size = stoi( split[ 2 ] ) ;
-                int pmem_size = stoi( split[ 3 ] ) ;
-                int page_size = stoi( split[ 4 ] ) ;
-                vmem = new virtual_memory( vmem_size, pmem_size, page_size ) ;
-                cout << "Virtual memory initialized: " << vmem_size << " virtual, " << pmem_size << " physical, page size " << page_size << endl ;
+            if( split[ 0 ] == "init" && split.size() >= 2 && split[ 1 ] == "numa" ){
+                if( split.size() >= 3 ){
+                    vector < int > caps ;
+                    int total = 0 ;
+                    bool positive = true ;
+                    for( int i = 2 ; i < (int)split.size() ; i++ ){
+                        caps.push_back( stoi( split[ i ] ) ) ;
+                        total += caps.back() ;
+                        if( caps.back() <= 0 ) positive = false ;
+                    }
+                    // Frames are assigned to nodes by address, so the nodes must tile physical memory exactly
+                    if( !positive ){
+                        cout << "Node capacities must be positive" << endl ;
+                    } else if( vmem != NULL && total != vmem->pmem_size ){
+                        cout << "Node capacities sum to " << total << " but physical memory is " << vmem->pmem_size << endl ;
+                    } else {
+                        numa = new numa_topology( caps ) ;
+                        if( vmem != NULL ) vmem->attach_numa( numa ) ;
+                        cout << "NUMA initialized with " << caps.size() << " nodes" << endl ;
+                    }
+                } else {
+                    cout << "Usage: init numa <node0_size> [node1_size ...]" << endl ;
+                }
             }
-            
-            if( split[ 0 ] == "translate" ){
-                if( vmem != NULL ){
-                    int virtual_addr = stoi( split[ 1 ] ) ;
-                    int physical_addr = vmem->translate( virtual_addr ) ;
-                    cout << "Virtual address " << virtual_addr << " -> Physical address " << physical_addr << endl ;
+
+            if( split[ 0 ] == "numa" ){
+                if( numa == NULL ){
+                    cout << "NUMA not initialized. Use 'init numa <sizes...>' first" << endl ;
+                } else if( split.size() >= 5 && split[ 1 ] == "distance" && ( !numa->valid_node( stoi( split[ 2 ] ) ) || !numa->valid_node( stoi( split[ 3 ] ) ) ) ){
+                    cout << "Node IDs must be between 0 and " << numa->num_nodes - 1 << endl ;
+                } else if( split.size() >= 5 && split[ 1 ] == "distance" && stoi( split[ 4 ] ) < 1 ){
+                    cout << "Distance must be at least 1" << endl ;
+                } else if( split.size() >= 5 && split[ 1 ] == "distance" && !numa->consistent_distance( stoi( split[ 2 ] ) , stoi( split[ 3 ] ) , stoi( split[ 4 ] ) ) ){
+                    cout << "Local distance cannot exceed a remote distance" << endl ;
+                } else if( split.size() >= 5 && split[ 1 ] == "distance" ){
+                    int from = stoi( split[ 2 ] ) , to = stoi( split[ 3 ] ) ;
+                    numa->distance[ from ][ to ] = stoi( split[ 4 ] ) ;
+                    numa->distance[ to ][ from ] = stoi( split[ 4 ] ) ;
+                    cout << "Distance between node " << from << " and node " << to << " set to " << split[ 4 ] << endl ;
+                } else if( split.size() >= 3 && split[ 1 ] == "policy" && split[ 2 ] == "first-touch" ){
+                    numa->policy = 0 ;
+                    cout << "NUMA policy set to first-touch" << endl ;
+                } else if( split.size() >= 3 && split[ 1 ] == "policy" && split[ 2 ] == "interleave" ){
+                    numa->policy = 1 ;
+                    cout << "NUMA policy set to interleave" << endl ;
+                } else if( split.size() >= 4 && split[ 1 ] == "policy" && split[ 2 ] == "preferred" && !numa->valid_node( stoi( split[ 3 ] ) ) ){
+                    cout << "Node IDs must be between 0 and " << numa->num_nodes - 1 << endl ;
+                } else if( split.size() >= 4 && split[ 1 ] == "policy" && split[ 2 ] == "preferred" ){
+                    numa->policy = 2 ;
+                    numa->preferred = stoi( split[ 3 ] ) ;
+                    cout << "NUMA policy set to preferred node " << numa->preferred << endl ;
+                } else if( split.size() >= 4 && split[ 1 ] == "policy" && split[ 2 ] == "bind" ){
+                    vector < bool > allowed( numa->num_nodes , false ) ;
+                    bool valid = true ;
+                    for( int i = 3 ; i < (int)split.size() ; i++ ){
+                        int node = stoi( split[ i ] ) ;
+                        if( numa->valid_node( node ) ) allowed[ node ] = true ;
+                        else valid = false ;
+                    }
+                    if( !valid ){
+                        cout << "Node IDs must be between 0 and " << numa->num_nodes - 1 << endl ;
+                    } else {
+                        numa->policy = 3 ;
+                        numa->allowed = allowed ;
+                        cout << "NUMA policy set to bind" << endl ;
+                    }
+                } else if( split.size() >= 3 && split[ 1 ] == "cpu" && !numa->valid_node( stoi( split[ 2 ] ) ) ){
+                    cout << "Node IDs must be between 0 and " << numa->num_nodes - 1 << endl ;
+                } else if( split.size() >= 3 && split[ 1 ] == "cpu" ){
+                    numa->cpu_node = stoi( split[ 2 ] ) ;
+                    cout << "Running on node " << numa->cpu_node << endl ;
+                } else if( split.size() >= 3 && split[ 1 ] == "migrate" && stoi( split[ 2 ] ) < 0 ){
+                    cout << "Migration threshold cannot be negative" << endl ;
+                } else if( split.size() >= 3 && split[ 1 ] == "migrate" ){
+                    numa->migrate_threshold = stoi( split[ 2 ] ) ;
+                    cout << "Page migration threshold set to " << numa->migrate_threshold << endl ;
+                } else if( split.size() >= 3 && split[ 1 ] == "malloc" && stoi( split[ 2 ] ) <= 0 ){
+                    cout << "Allocation size must be positive" << endl ;
+                } else if( split.size() >= 3 && split[ 1 ] == "malloc" ){
+                    numa->malloc_block( stoi( split[ 2 ] ) ) ;
+                } else if( split.size() >= 3 && split[ 1 ] == "free" ){
+                    numa->free_block( stoi( split[ 2 ] ) ) ;
+                } else if( split.size() >= 2 && split[ 1 ] == "stats" ){
+                    if( vmem != NULL && vmem->numa == numa ) vmem->count_numa_frames() ;
+                    numa->stats() ;
+                } else {
+                    cout << "Usage: numa <distance|policy|cpu|migrate|malloc|free|stats> ..." << endl ;
+                }
+            }
+
+            if( split[ 0 ] == "mt" ){
+                if( split.size() >= 6 && split[ 1 ] == "bench" ){
+                    int max_threads = stoi( split[ 2 ] ) ;
+                    int arena_count = stoi( split[ 3 ] ) ;
+                    int arena_size = stoi( split[ 4 ] ) ;
+                    int ops = stoi( split[ 5 ] ) ;
+                    if( max_threads < 1 || arena_count < 1 || arena_size < 1 || ops < 1 ){
+                        cout << "Threads, arenas, arena size and ops must all be at least 1" << endl ;
+                    } else {
+                        arena_scaling( {} , max_threads , ops , 0 , arena_count , arena_size ) ;
+                    }
+                } else if( split.size() >= 5 && split[ 1 ] == "replay" && ( stoi( split[ 3 ] ) < 1 || stoi( split[ 4 ] ) < 1 ) ){
+                    cout << "Arenas and arena size must be at least 1" << endl ;
+                } else if( split.size() >= 5 && split[ 1 ] == "replay" ){
+                    vector < vector < mt_op > > traces ;
+                    int tags = 0 ;
+                    if( !load_mt_trace( split[ 2 ] , traces , tags ) || traces.empty() ){
+                        cout << "Could not read trace " << split[ 2 ] << endl ;
+                    } else {
+                        cout << "Replaying " << traces.size() << " thread traces from " << split[ 2 ] << endl ;
+                        arena_scaling( traces , traces.size() , 0 , tags , stoi( split[ 3 ] ) , stoi( split[ 4 ] ) ) ;
+                    }
                 } else {
+                    cout << "Usage: mt bench <max_threads> <arenas> <arena_size> <ops_per_thread>" << endl ;
+                    cout << "       mt replay <trace_file> <arenas> <arena_size>" << endl ;
+                }
+            }
+
+            if( split[ 0 ] == "vm" && split.size() >= 2 && split[ 1 ] == "stats" ){
+                if( vmem == NULL ){
                     cout << "Virtual memory not initialized" << endl ;
+                } else {
+                    cout << "Page Replacement: " << vmem->policy_name() << ", Translations: " << vmem->translations
+                         << ", Page Faults: " << vmem->page_faults << ", Fault Rate: " << vmem->fault_rate() << endl ;
+                    if( !vmem->spans_seen().empty() ) vmem->page_size_stats() ;
                 }
             }
 
-            if( split[ 0 ] == "cache" && split[ 1 ] == "stats" ){
-                if( l1_cache != NULL ){
-                    cout << "L1 Cache - Hits: " << l1_cache->hits << ", Misses: " << l1_cache->misses 
-                         << ", Hit Ratio: " << l1_cache->hit_ratio() << endl ;
+            if( split[ 0 ] == "replay" ){
+                if( vmem == NULL ){
+                    cout << "Virtual memory not initialized" << endl ;
+                } else if( split.size() >= 3 && ( split[ 1 ] == "all" || policy_code( split[ 1 ] ) != -1 ) ){
+                    replay( vmem , split[ 1 ] , split[ 2 ] ) ;
+                } else {
+                    cout << "Usage: replay <lru|fifo|clock|second|wsclock|aging|opt|all> <trace_file>" << endl ;
                 }
-                if( l2_cache != NULL ){
-                    cout << "L2 Cache - Hits: " << l2_cache->hits << ", Misses: " << l2_cache->misses 
-                         << ", Hit Ratio: " << l2_cache->hit_ratio() << endl ;
+            }
+
+            if( split[ 0 ] == "access" ){
+                if( split.size() >= 2 && split[ 1 ] == "stats" ){
+                    pipeline.stats() ;
+                } else if( vmem == NULL ){
+                    cout << "Virtual memory not initialized" << endl ;
+                } else if( split.size() >= 2 && ( stoi( split[ 1 ] ) < 0 || stoi( split[ 1 ] ) >= vmem->vmem_size ) ){
+                    cout << "Virtual address out of range (0 to " << vmem->vmem_size - 1 << ")" << endl ;
+                } else if( split.size() >= 2 ){
+                    pipeline.access( stoi( split[ 1 ] ) , vmem , l1_cache , l2_cache ) ;
+                } else {
+                    cout << "Usage: access <virtual_addr>" << endl ;
+                }
+            }
+
+            if( split[ 0 ] == "trace" ){
+                if( split.size() < 2 ){
+                    cout << "Usage: trace <file> [data] [sample <fraction>]" << endl ;
+                } else {
+                    trace_importer importer ;
+                    bool ok = true ;
+                    for( int i = 2 ; i < (int)split.size() ; i++ ){
+                        if( split[ i ] == "data" ) importer.data_only = true ;
+                        else if( split[ i ] == "sample" && i + 1 < (int)split.size() ){
+                            // Sample every k-th set, k the power of two nearest 1/fraction from below
+                            double fraction = stod( split[ ++i ] ) ;
+                            if( fraction <= 0 || fraction > 1 ){
+                                cout << "Sample fraction must be greater than 0 and at most 1" << endl ;
+                                ok = false ;
+                            }
+                            while( fraction > 0 && importer.sample_stride * 2 <= 1.0 / fraction ) importer.sample_stride *= 2 ;
+                        }
+                        else ok = false ;
+                    }
+                    if( importer.sample_stride > 1 ){
+                        int max_stride = 1 << 30 ;
+                        if( l1_cache != NULL ) max_stride = min( max_stride , l1_cache->sets ) ;
+                        if( l2_cache != NULL ) max_stride = min( max_stride , l2_cache->sets ) ;
+                        if( l1_cache == NULL && l2_cache == NULL ){
+                            cout << "Cache not initialized, sampling ignored" << endl ;
+                            importer.sample_stride = 1 ;
+                        } else if( l1_cache != NULL && l2_cache != NULL && l1_cache->Blocksize != l2_cache->Blocksize ){
+                            cout << "Set sampling needs equal L1 and L2 block sizes" << endl ;
+                            ok = false ;
+                        } else if( ( l1_cache != NULL && l1_cache->prefetcher != 0 ) || ( l2_cache != NULL && l2_cache->prefetcher != 0 ) ){
+                            // Prefetches of neighbouring blocks would land in unsampled sets
+                            cout << "Set sampling cannot be combined with prefetchers" << endl ;
+                            ok = false ;
+                        } else {
+                            importer.sample_stride = min( importer.sample_stride , max_stride ) ;
+                        }
+                    }
+                    if( !ok ){
+                        cout << "Usage: trace <file> [data] [sample <fraction>]" << endl ;
+                    } else if( !importer.run( split[ 1 ] , vmem , l1_cache , l2_cache , pipeline ) ){
+                        cout << "Cannot open trace file " << split[ 1 ] << endl ;
+                    } else {
+                        importer.report( split[ 1 ] , vmem , l1_cache , l2_cache ) ;
+                    }
                 }
             }
 
@@ -157,11 +542,33 @@ struct cli{
                 cout << "init memory <size>              - Initialize physical memory" << endl ;
                 cout << "init virtual <vmem> <pmem> <page> - Initialize virtual memory" << endl ;
                 cout << "init cache <1|2>                - Initialize L1 or L2 cache" << endl ;
+                cout << "init numa <size...>             - Initialize NUMA nodes with the given capacities" << endl ;
+                cout << "numa distance <a> <b> <d>        - Set the distance between two nodes (10 is local)" << endl ;
+                cout << "numa policy <first-touch|interleave|preferred <n>|bind <n...>> - Set NUMA placement" << endl ;
+                cout << "numa cpu <node>                  - Set the node requests are issued from" << endl ;
+                cout << "numa migrate <accesses>          - Remote accesses in a row before a page migrates (0 = off)" << endl ;
+                cout << "numa malloc <size> / numa free <id> - Allocate or free on a node chosen by the policy" << endl ;
+                cout << "numa stats                       - Show per-node usage and local/remote access ratios" << endl ;
                 cout << "set allocator <first|best|worst> - Set memory allocation strategy" << endl ;
                 cout << "malloc <size>                    - Allocate memory" << endl ;
                 cout << "free <id>                        - Free memory by ID" << endl ;
+                cout << "mt bench <threads> <arenas> <arena_size> <ops> - Multi-arena allocator scaling, synthetic traces" << endl ;
+                cout << "mt replay <file> <arenas> <arena_size> - Multi-arena allocator scaling, per-thread trace file" << endl ;
+                cout << "compact                          - Slide all blocks down into one free hole" << endl ;
+                cout << "compact step <budget>            - Compact incrementally, moving at most <budget> units" << endl ;
+                cout << "set compaction <on|off>          - Compact automatically when an allocation fails" << endl ;
                 cout << "read <address>                   - Read from memory (cache simulation)" << endl ;
                 cout << "translate <virtual_addr>         - Translate virtual to physical address" << endl ;
+                cout << "set replacement <policy> [window] - Page replacement: lru, fifo, clock, second, wsclock, aging" << endl ;
+                cout << "vm stats                         - Show page replacement policy and fault counts" << endl ;
+                cout << "set hugepages <size...|off>      - Enable huge page sizes (multiples of the page size)" << endl ;
+                cout << "set thp <never|promote|always> [threshold%] - Huge page mode and promotion density" << endl ;
+                cout << "replay <policy|all> <file>       - Replay a virtual address trace, faults per policy (incl. opt)" << endl ;
+                cout << "access <virtual_addr>            - Translate, then read through L1/L2/memory with cycle count" << endl ;
+                cout << "access stats                     - Show access cycle totals and AMAT" << endl ;
+                cout << "set latency <l1|l2|memory|fault|migrate> <cycles> - Set the latency of a level or of a page migration" << endl ;
+                cout << "trace <file> [data] [sample <f>] - Stream a Lackey or R/W CSV trace through VM and caches" << endl ;
+                cout << "set prefetcher <1|2> <none|next|stride|stream> [degree] [delay] - Set a cache level's prefetcher" << endl ;
                 cout << "dump                             - Show memory layout" << endl ;
                 cout << "stats                            - Show memory statistics" << endl ;
                 cout << "cache stats                      - Show cache statistics" << endl ;
@@ -249,11 +656,14 @@ struct cli{
             
             // Virtual Memory Commands
             if( split[ 0 ] == "init" && split[ 1 ] == "virtual" ){
-                if( split.size() >= 5 ){
+                if( split.size() >= 5 && numa != NULL && numa->total_capacity() != stoi( split[ 3 ] ) ){
+                    cout << "NUMA node capacities sum to " << numa->total_capacity() << " but physical memory is " << split[ 3 ] << endl ;
+                } else if( split.size() >= 5 ){
                     int vmem_size = stoi( split[ 2 ] ) ;
                     int pmem_size = stoi( split[ 3 ] ) ;
                     int page_size = stoi( split[ 4 ] ) ;
                     vmem = new virtual_memory( vmem_size, pmem_size, page_size ) ;
+                    if( numa != NULL ) vmem->attach_numa( numa ) ;
                     cout << "Virtual memory initialized: " << vmem_size << " virtual, " << pmem_size << " physical, page size " << page_size << endl ;
                 } else {
                     cout << "Usage: init virtual <vmem_size> <pmem_size> <page_size>" << endl ;
@@ -261,10 +671,16 @@ struct cli{
             }
             
             if( split[ 0 ] == "translate" ){
-                if( vmem != NULL && split.size() >= 2 ){
+                if( vmem != NULL && split.size() >= 2 && ( stoi( split[ 1 ] ) < 0 || stoi( split[ 1 ] ) >= vmem->vmem_size ) ){
+                    cout << "Virtual address out of range (0 to " << vmem->vmem_size - 1 << ")" << endl ;
+                } else if( vmem != NULL && split.size() >= 2 ){
                     int virtual_addr = stoi( split[ 1 ] ) ;
+                    int faults_before = vmem->page_faults ;
                     int physical_addr = vmem->translate( virtual_addr ) ;
+                    if( vmem->page_faults != faults_before ) pipeline.flush_refilled( vmem , l1_cache , l2_cache ) ;
                     cout << "Virtual address " << virtual_addr << " -> Physical address " << physical_addr << endl ;
+                    // translate models no caches, so the reference goes to memory
+                    pipeline.numa_reference( physical_addr , vmem , l1_cache , l2_cache ) ;
                 } else if( vmem == NULL ){
                     cout << "Virtual memory not initialized" << endl ;
                 } else {
@@ -276,10 +692,12 @@ struct cli{
                 if( l1_cache != NULL ){
                     cout << "L1 Cache - Hits: " << l1_cache->hits << ", Misses: " << l1_cache->misses 
                          << ", Hit Ratio: " << l1_cache->hit_ratio() << endl ;
+                    l1_cache->prefetch_stats( "L1" ) ;
                 }
                 if( l2_cache != NULL ){
                     cout << "L2 Cache - Hits: " << l2_cache->hits << ", Misses: " << l2_cache->misses 
                          << ", Hit Ratio: " << l2_cache->hit_ratio() << endl ;
+                    l2_cache->prefetch_stats( "L2" ) ;
                 }
                 if( l1_cache == NULL && l2_cache == NULL ){
                     cout << "No cache initialized" << endl ;
@@ -291,11 +709,33 @@ struct cli{
                 cout << "init memory <size>              - Initialize physical memory" << endl ;
                 cout << "init virtual <vmem> <pmem> <page> - Initialize virtual memory" << endl ;
                 cout << "init cache <1|2>                - Initialize L1 or L2 cache" << endl ;
+                cout << "init numa <size...>             - Initialize NUMA nodes with the given capacities" << endl ;
+                cout << "numa distance <a> <b> <d>        - Set the distance between two nodes (10 is local)" << endl ;
+                cout << "numa policy <first-touch|interleave|preferred <n>|bind <n...>> - Set NUMA placement" << endl ;
+                cout << "numa cpu <node>                  - Set the node requests are issued from" << endl ;
+                cout << "numa migrate <accesses>          - Remote accesses in a row before a page migrates (0 = off)" << endl ;
+                cout << "numa malloc <size> / numa free <id> - Allocate or free on a node chosen by the policy" << endl ;
+                cout << "numa stats                       - Show per-node usage and local/remote access ratios" << endl ;
                 cout << "set allocator <first|best|worst> - Set memory allocation strategy" << endl ;
                 cout << "malloc <size>                    - Allocate memory" << endl ;
                 cout << "free <id>                        - Free memory by ID" << endl ;
+                cout << "mt bench <threads> <arenas> <arena_size> <ops> - Multi-arena allocator scaling, synthetic traces" << endl ;
+                cout << "mt replay <file> <arenas> <arena_size> - Multi-arena allocator scaling, per-thread trace file" << endl ;
+                cout << "compact                          - Slide all blocks down into one free hole" << endl ;
+                cout << "compact step <budget>            - Compact incrementally, moving at most <budget> units" << endl ;
+                cout << "set compaction <on|off>          - Compact automatically when an allocation fails" << endl ;
                 cout << "read <address>                   - Read from memory (cache simulation)" << endl ;
                 cout << "translate <virtual_addr>         - Translate virtual to physical address" << endl ;
+                cout << "set replacement <policy> [window] - Page replacement: lru, fifo, clock, second, wsclock, aging" << endl ;
+                cout << "vm stats                         - Show page replacement policy and fault counts" << endl ;
+                cout << "set hugepages <size...|off>      - Enable huge page sizes (multiples of the page size)" << endl ;
+                cout << "set thp <never|promote|always> [threshold%] - Huge page mode and promotion density" << endl ;
+                cout << "replay <policy|all> <file>       - Replay a virtual address trace, faults per policy (incl. opt)" << endl ;
+                cout << "access <virtual_addr>            - Translate, then read through L1/L2/memory with cycle count" << endl ;
+                cout << "access stats                     - Show access cycle totals and AMAT" << endl ;
+                cout << "set latency <l1|l2|memory|fault|migrate> <cycles> - Set the latency of a level or of a page migration" << endl ;
+                cout << "trace <file> [data] [sample <f>] - Stream a Lackey or R/W CSV trace through VM and caches" << endl ;
+                cout << "set prefetcher <1|2> <none|next|stride|stream> [degree] [delay] - Set a cache level's prefetcher" << endl ;
                 cout << "dump                             - Show memory layout" << endl ;
                 cout << "stats                            - Show memory statistics" << endl ;
                 cout << "cache stats                      - Show cache statistics" << endl ;
@@ -0,0 +1,369 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include "memory.hpp"
+using namespace std ;
+
+// Concurrent allocator front-end: the address space is sharded into several
+// Memory arenas, each behind its own mutex, with a per-thread cache of small
+// freed blocks in front so that most small malloc/free pairs never lock.
+
+struct mt_op{
+
+    bool is_malloc ;
+    int tag ;       // names the allocation across threads
+    int size ;
+
+};
+
+struct handle{
+
+    int arena = -1 ;
+    int id = -1 ;
+    int size_class = 0 ;    // 0 for blocks too large to be cached
+    int owner = -1 ;        // thread that allocated it
+
+};
+
+struct arena{
+
+    Memory memory ;
+    mutex lock ;
+
+    // Updated while holding lock
+    int acquisitions = 0 ;
+    int contended = 0 ;
+    long long wait_ns = 0 ;
+
+    arena( int size ) : memory( size , false ) {}
+
+    void acquire(){
+        if( lock.try_lock() ){
+            acquisitions++ ;
+            return ;
+        }
+        auto start = chrono::steady_clock::now() ;
+        lock.lock() ;
+        acquisitions++ ;
+        contended++ ;
+        wait_ns += chrono::duration_cast< chrono::nanoseconds >( chrono::steady_clock::now() - start ).count() ;
+    }
+
+    void release(){
+        lock.unlock() ;
+    }
+
+};
+
+struct worker_stats{
+
+    long long ops = 0 ;
+    int cache_hits = 0 ;
+    int cross_thread_frees = 0 ;
+    int failed = 0 ;
+    int spills = 0 ;    // allocations served by an arena other than the home one
+
+};
+
+struct arena_allocator{
+
+    int num_arenas ;
+    int arena_size ;
+    int small_limit = 256 ;     // sizes up to this are rounded to a size class and cached
+    int cache_limit = 32 ;      // cached blocks per size class per thread
+    vector < arena* > arenas ;
+
+    // Per tag: 0 not yet allocated, 1 live, 2 allocation failed, 3 freed
+    vector < atomic < int > > tag_state ;
+    vector < handle > tag_handle ;
+
+    arena_allocator( int arena_count , int size , int tags )
+    : tag_state( tags ) , tag_handle( tags )
+    {
+        num_arenas = arena_count ;
+        arena_size = size ;
+        for( int i = 0 ; i < num_arenas ; i++ ) arenas.push_back( new arena( arena_size ) ) ;
+        for( auto &state : tag_state ) state.store( 0 ) ;
+    }
+
+    ~arena_allocator(){
+        for( arena* a : arenas ) delete a ;
+    }
+
+    int size_class( int size ){
+        if( size > small_limit ) return 0 ;
+        int cls = 16 ;
+        while( cls < size ) cls <<= 1 ;
+        return cls ;
+    }
+
+    handle allocate( int thread , int size , map < int , vector < handle > > &cache , worker_stats &stats ){
+
+        handle h ;
+        h.size_class = size_class( size ) ;
+        h.owner = thread ;
+
+        if( h.size_class > 0 && !cache[ h.size_class ].empty() ){
+            h = cache[ h.size_class ].back() ;
+            cache[ h.size_class ].pop_back() ;
+            h.owner = thread ;
+            stats.cache_hits++ ;
+            return h ;
+        }
+
+        int request = ( h.size_class > 0 ) ? h.size_class : size ;
+        int home = thread % num_arenas ;
+        for( int i = 0 ; i < num_arenas ; i++ ){
+            int index = ( home + i ) % num_arenas ;
+            arenas[ index ]->acquire() ;
+            int id = arenas[ index ]->memory.first_fit( request ) ;
+            arenas[ index ]->release() ;
+            if( id != -1 ){
+                if( i > 0 ) stats.spills++ ;
+                h.arena = index ;
+                h.id = id ;
+                return h ;
+            }
+        }
+
+        stats.failed++ ;
+        return h ;
+    }
+
+    void release_block( handle h ){
+        arenas[ h.arena ]->acquire() ;
+        arenas[ h.arena ]->memory.free_memory( h.id ) ;
+        arenas[ h.arena ]->release() ;
+    }
+
+    void deallocate( int thread , handle h , map < int , vector < handle > > &cache , worker_stats &stats ){
+
+        // Remote frees go straight back to the owning arena
+        if( h.owner != thread ){
+            stats.cross_thread_frees++ ;
+            release_block( h ) ;
+            return ;
+        }
+
+        if( h.size_class > 0 ){
+            vector < handle > &list = cache[ h.size_class ] ;
+            list.push_back( h ) ;
+            if( (int)list.size() > cache_limit ){
+                // Return the older half so the cache stays bounded
+                int keep = cache_limit / 2 ;
+                for( int i = 0 ; i < (int)list.size() - keep ; i++ ) release_block( list[ i ] ) ;
+                list.erase( list.begin() , list.end() - keep ) ;
+            }
+            return ;
+        }
+
+        release_block( h ) ;
+    }
+
+    // Returns false while the tag's allocation has not been published yet
+    bool try_free( int thread , int tag , map < int , vector < handle > > &cache , worker_stats &stats ){
+        int state = tag_state[ tag ].load( memory_order_acquire ) ;
+        if( state == 0 ) return false ;
+        if( state == 1 ){
+            deallocate( thread , tag_handle[ tag ] , cache , stats ) ;
+            tag_state[ tag ].store( 3 , memory_order_release ) ;
+        }
+        return true ;
+    }
+
+    void worker( int thread , vector < mt_op > &trace , worker_stats &stats ){
+
+        map < int , vector < handle > > cache ;
+        deque < int > deferred ;
+
+        for( mt_op &op : trace ){
+            if( op.is_malloc ){
+                handle h = allocate( thread , op.size , cache , stats ) ;
+                tag_handle[ op.tag ] = h ;
+                tag_state[ op.tag ].store( ( h.id != -1 ) ? 1 : 2 , memory_order_release ) ;
+            }
+            else if( !try_free( thread , op.tag , cache , stats ) ){
+                // Allocated by a thread that has not got there yet
+                deferred.push_back( op.tag ) ;
+            }
+            stats.ops++ ;
+
+            while( !deferred.empty() && try_free( thread , deferred.front() , cache , stats ) ) deferred.pop_front() ;
+        }
+
+        // Every malloc this thread waits on is issued by a thread that never blocks
+        while( !deferred.empty() ){
+            if( try_free( thread , deferred.front() , cache , stats ) ) deferred.pop_front() ;
+            else this_thread::yield() ;
+        }
+
+        for( auto &entry : cache ){
+            for( handle &h : entry.second ) release_block( h ) ;
+        }
+    }
+
+};
+
+// Deterministic synthetic workload: mostly small objects, some large ones,
+// and a share of each thread's blocks handed to the next thread to free.
+inline vector < vector < mt_op > > synthetic_traces( int threads , int ops , int &tags ){
+
+    vector < vector < mt_op > > traces( threads ) ;
+    vector < vector < int > > handed( threads ) ;
+    tags = 0 ;
+
+    for( int t = 0 ; t < threads ; t++ ){
+        mt19937 rng( 1000 + t ) ;
+        vector < int > live ;
+        for( int i = 0 ; i < ops ; i++ ){
+            if( live.empty() || rng() % 100 < 55 ){
+                int size = ( rng() % 100 < 85 ) ? 8 + rng() % 249 : 512 + rng() % 3585 ;
+                traces[ t ].push_back( { true , tags , size } ) ;
+                live.push_back( tags++ ) ;
+            }
+            else{
+                int pick = rng() % live.size() ;
+                int tag = live[ pick ] ;
+                live.erase( live.begin() + pick ) ;
+                if( threads > 1 && rng() % 100 < 20 ) handed[ ( t + 1 ) % threads ].push_back( tag ) ;
+                else traces[ t ].push_back( { false , tag , 0 } ) ;
+            }
+        }
+    }
+
+    // Interleave the handed-over frees into the receiving thread's trace
+    for( int t = 0 ; t < threads ; t++ ){
+        vector < mt_op > merged ;
+        int step = handed[ t ].empty() ? 0 : traces[ t ].size() / handed[ t ].size() + 1 ;
+        int next = 0 ;
+        for( int i = 0 ; i < (int)traces[ t ].size() ; i++ ){
+            merged.push_back( traces[ t ][ i ] ) ;
+            if( step > 0 && i % step == step - 1 && next < (int)handed[ t ].size() ){
+                merged.push_back( { false , handed[ t ][ next++ ] , 0 } ) ;
+            }
+        }
+        while( next < (int)handed[ t ].size() ) merged.push_back( { false , handed[ t ][ next++ ] , 0 } ) ;
+        traces[ t ] = merged ;
+    }
+
+    return traces ;
+}
+
+// Trace file lines: "<thread> malloc <tag> <size>" or "<thread> free <tag>".
+// Tags may be reused once freed (traces often use addresses as tags): every
+// malloc gets a fresh index and a free refers to the latest malloc of its tag.
+inline bool load_mt_trace( string file , vector < vector < mt_op > > &traces , int &tags ){
+
+    ifstream in( file ) ;
+    if( !in ) return false ;
+
+    map < int , int > tag_index ;
+    tags = 0 ;
+    string line ;
+    while( getline( in , line ) ){
+        if( line.empty() || line[ 0 ] == '#' ) continue ;
+        int thread , tag , size = 0 ;
+        char kind[ 16 ] ;
+        if( sscanf( line.c_str() , "%d %15s %d %d" , &thread , kind , &tag , &size ) < 3 ) continue ;
+        bool is_malloc = ( string( kind ) == "malloc" ) ;
+        if( !is_malloc && string( kind ) != "free" ) continue ;
+        if( thread < 0 ){
+            cout << "Invalid thread number in trace line: " << line << endl ;
+            return false ;
+        }
+        // A free without an earlier malloc gets an index nobody allocates, so it is dropped
+        if( is_malloc || tag_index.count( tag ) == 0 ) tag_index[ tag ] = tags++ ;
+        if( thread >= (int)traces.size() ) traces.resize( thread + 1 ) ;
+        traces[ thread ].push_back( { is_malloc , tag_index[ tag ] , size } ) ;
+    }
+    return true ;
+}
+
+// Runs the first `threads` traces on real threads and prints one scaling row
+inline double run_arena_threads( vector < vector < mt_op > > &traces , int threads , int tags , int arena_count , int arena_size , double base_throughput ){
+
+    // Frees of blocks owned by threads outside this run are dropped
+    vector < int > owner( tags , -1 ) ;
+    for( int t = 0 ; t < threads ; t++ ){
+        for( mt_op &op : traces[ t ] ){
+            if( op.is_malloc ) owner[ op.tag ] = t ;
+        }
+    }
+    vector < vector < mt_op > > active( threads ) ;
+    for( int t = 0 ; t < threads ; t++ ){
+        for( mt_op &op : traces[ t ] ){
+            if( op.is_malloc || owner[ op.tag ] != -1 ) active[ t ].push_back( op ) ;
+        }
+    }
+
+    arena_allocator allocator( arena_count , arena_size , tags ) ;
+    vector < worker_stats > stats( threads ) ;
+    vector < thread > workers ;
+
+    auto start = chrono::steady_clock::now() ;
+    for( int t = 0 ; t < threads ; t++ ){
+        workers.emplace_back( &arena_allocator::worker , &allocator , t , ref( active[ t ] ) , ref( stats[ t ] ) ) ;
+    }
+    for( thread &w : workers ) w.join() ;
+    double elapsed_ms = chrono::duration< double , milli >( chrono::steady_clock::now() - start ).count() ;
+
+    worker_stats total ;
+    for( worker_stats &s : stats ){
+        total.ops += s.ops ;
+        total.cache_hits += s.cache_hits ;
+        total.cross_thread_frees += s.cross_thread_frees ;
+        total.failed += s.failed ;
+        total.spills += s.spills ;
+    }
+    int acquisitions = 0 , contended = 0 ;
+    long long wait_ns = 0 ;
+    for( arena* a : allocator.arenas ){
+        acquisitions += a->acquisitions ;
+        contended += a->contended ;
+        wait_ns += a->wait_ns ;
+    }
+
+    double throughput = ( elapsed_ms > 0 ) ? total.ops / elapsed_ms : 0 ;
+    cout << "Threads: " << threads << ", Ops: " << total.ops << ", Time: " << elapsed_ms << " ms"
+         << ", Throughput: " << throughput << " ops/ms" ;
+    if( base_throughput > 0 ) cout << ", Speedup: " << throughput / base_throughput ;
+    cout << endl ;
+    cout << "  Lock Acquisitions: " << acquisitions << ", Contended: " << contended
+         << ", Lock Wait: " << wait_ns / 1000 << " us" << endl ;
+    cout << "  Cache Hits: " << total.cache_hits << ", Cross-thread Frees: " << total.cross_thread_frees
+         << ", Arena Spills: " << total.spills << ", Failed Allocations: " << total.failed << endl ;
+
+    return throughput ;
+}
+
+// Throughput scaling from 1 thread up to max_threads, doubling each step.
+// With ops > 0 a synthetic trace set is generated for every thread count,
+// otherwise the given traces are replayed.
+inline void arena_scaling( vector < vector < mt_op > > traces , int max_threads , int ops , int tags , int arena_count , int arena_size ){
+
+    vector < int > counts ;
+    for( int threads = 1 ; threads < max_threads ; threads *= 2 ) counts.push_back( threads ) ;
+    counts.push_back( max_threads ) ;
+
+    cout << "Arenas: " << arena_count << " x " << arena_size << ", Hardware threads: " << thread::hardware_concurrency() << endl ;
+    double base = 0 ;
+    for( int threads : counts ){
+        if( ops > 0 ) traces = synthetic_traces( threads , ops , tags ) ;
+        double throughput = run_arena_threads( traces , threads , tags , arena_count , arena_size , base ) ;
+        if( threads == 1 ) base = throughput ;
+    }
+}
+
+#endif // ARENA_HPP
@@ -37,47 +37,61 @@ struct Memory{
     int total_allocations = 0 ;
     int successful_allocations = 0 ;
     int failed_allocations = 0 ;
+
+    // Compaction accounting
+    bool auto_compact = false ;
+    int compactions = 0 ;
+    int bytes_moved = 0 ;
+    int compaction_rescues = 0 ;
+    int recoverable_failures = 0 ;
+
+    // Arenas run many allocators side by side and turn per-call output off
+    bool verbose = true ;
     
-    Memory( int size ){
+    Memory( int size , bool talk = true ){
+        verbose = talk ;
         head = new Block( 0 , size, 1 , 1 ,NULL  , NULL ) ;
-        cout << "memory of size " << size << " created " << endl ;
+        if( verbose ) cout << "memory of size " << size << " created " << endl ;
     }
 
-    void first_fit( int size ){
+    // Returns the ID of the new block, or -1 if it could not be placed
+    int first_fit( int size ){
         
         total_allocations++ ;
-        bool found = 0 ;
         Block* node = head ;
-        while( node != NULL && found == 0 ){
-
-            if( node->Size >= size && node->flag == 1 ){
-                found = 1 ;
-                successful_allocations++ ;
-                Id++ ;
-                node->Id = Id ;
-                node->flag = 0 ;
-                int extra = node->Size - size ;
-                node->Size = size ;
-                cout << "Memory allocated with ID: " << Id << " using first-fit" << endl ;
-                if( extra > 0 ){
-                    Block * after = node->next ;
-                    Block* left = new Block( node->startaddress + size , extra , 0 , 1 , after , node ) ;
-                    node->next = left ;
-                    if( after != NULL ) after->prev = left ;
-                } 
-            }
-
+        Block* found = NULL ;
+        while( node != NULL && found == NULL ){
+            if( node->Size >= size && node->flag == 1 ) found = node ;
             node = node->next ;
         }
+        if( found == NULL ) found = retry_after_compaction( size ) ;
 
-        if( found == 0 ){
+        if( found == NULL ){
             failed_allocations++ ;
-            cout << "memory not available"  << endl ;
+            if( verbose ) cout << "memory not available"  << endl ;
+            return -1 ;
+        }
+        else{
+            successful_allocations++ ;
+            node = found ;
+            Id++ ;
+            node->Id = Id ;
+            node->flag = 0 ;
+            int extra = node->Size - size ;
+            node->Size = size ;
+            if( verbose ) cout << "Memory allocated with ID: " << Id << " using first-fit" << endl ;
+            if( extra > 0 ){
+                Block * after = node->next ;
+                Block* left = new Block( node->startaddress + size , extra , 0 , 1 , after , node ) ;
+                node->next = left ;
+                if( after != NULL ) after->prev = left ;
+            } 
+            return Id ;
         }
     
     }
 
-    void best_fit( int size ){
+    int best_fit( int size ){
         total_allocations++ ;
         Block *node = head ;
         Block* found = NULL ;
@@ -93,9 +107,12 @@ struct Memory{
             }
             node = node->next ;
         }
+        if( found == NULL ) found = retry_after_compaction( size ) ;
+
         if( found == NULL ){
             failed_allocations++ ;
-            cout << "memory not available"  << endl ;
+            if( verbose ) cout << "memory not available"  << endl ;
+            return -1 ;
         }
         else{
             successful_allocations++ ;
@@ -105,18 +122,19 @@ struct Memory{
             node->flag = 0 ;
             int extra = node->Size - size ;
             node->Size = size ;
-            cout << "Memory allocated with ID: " << Id << " using best-fit" << endl ;
+            if( verbose ) cout << "Memory allocated with ID: " << Id << " using best-fit" << endl ;
             if( extra > 0 ){
                 Block * after = node->next ;
                 Block* left = new Block( node->startaddress + size , extra , 0 , 1 , after , node ) ;
                 node->next = left ;
                 if( after != NULL ) after->prev = left ;
             } 
+            return Id ;
         }
 
     }
 
-    void worst_fit( int size ){
+    int worst_fit( int size ){
         total_allocations++ ;
         Block *node = head ;
         Block* found = NULL ;
@@ -132,9 +150,12 @@ struct Memory{
             }
             node = node->next ;
         }
+        if( found == NULL ) found = retry_after_compaction( size ) ;
+
         if( found == NULL ){
             failed_allocations++ ;
-            cout << "memory not available"  << endl ;
+            if( verbose ) cout << "memory not available"  << endl ;
+            return -1 ;
         }
         else{
             successful_allocations++ ;
@@ -144,15 +165,140 @@ struct Memory{
             node->flag = 0 ;
             int extra = node->Size - size ;
             node->Size = size ;
-            cout << "Memory allocated with ID: " << Id << " using worst-fit" << endl ;
+            if( verbose ) cout << "Memory allocated with ID: " << Id << " using worst-fit" << endl ;
             if( extra > 0 ){
                 Block * after = node->next ;
                 Block* left = new Block( node->startaddress + size , extra , 0 , 1 , after , node ) ;
                 node->next = left ;
                 if( after != NULL ) after->prev = left ;
             } 
+            return Id ;
+        }
+
+    }
+
+    int free_space(){
+        int total_free = 0 ;
+        Block* node = head ;
+        while( node != NULL ){
+            if( node->flag ) total_free += node->Size ;
+            node = node->next ;
+        }
+        return total_free ;
+    }
+
+    // Called when no single hole fits the request. If enough free space exists
+    // in total, the failure is recoverable by compaction; with auto_compact on
+    // the heap is compacted and the trailing hole is handed back to the caller.
+    Block* retry_after_compaction( int size ){
+        if( size <= 0 || free_space() < size ) return NULL ;
+        if( !auto_compact ){
+            recoverable_failures++ ;
+            return NULL ;
+        }
+
+        if( verbose ) cout << "Allocation of " << size << " failed, compacting memory" << endl ;
+        compact() ;
+        Block* node = head ;
+        while( node->next != NULL ) node = node->next ;
+        if( node->flag != 1 || node->Size < size ) return NULL ;
+        compaction_rescues++ ;
+        return node ;
+    }
+
+    // Full sliding compaction: every allocated block keeps its ID and order but
+    // slides down to the lowest free address, leaving one hole at the end.
+    // Returns the number of units copied.
+    int compact(){
+        int address = 0 ;
+        int moved = 0 ;
+        int total_free = 0 ;
+        Block* node = head ;
+        Block* last = NULL ;
+        head = NULL ;
+
+        while( node != NULL ){
+            Block* after = node->next ;
+            if( node->flag ){
+                total_free += node->Size ;
+                delete node ;
+            }
+            else{
+                if( node->startaddress != address ) moved += node->Size ;
+                node->startaddress = address ;
+                address += node->Size ;
+                node->prev = last ;
+                node->next = NULL ;
+                if( last != NULL ) last->next = node ;
+                else head = node ;
+                last = node ;
+            }
+            node = after ;
+        }
+
+        if( total_free > 0 ){
+            Block* hole = new Block( address , total_free , 0 , 1 , NULL , last ) ;
+            if( last != NULL ) last->next = hole ;
+            else head = hole ;
+        }
+
+        if( moved > 0 ) compactions++ ;
+        bytes_moved += moved ;
+        return moved ;
+    }
+
+    // Incremental compaction: swap allocated blocks with the hole in front of
+    // them, lowest address first. Blocks larger than what is left of the budget
+    // are skipped. Holes bubble towards the end and coalesce as they meet.
+    int compact_step( int budget ){
+        int moved = 0 ;
+        Block* node = head ;
+
+        while( node != NULL ){
+            Block* used = node->next ;
+            if( node->flag == 1 && used != NULL && used->flag == 0 ){
+                if( moved + used->Size > budget ){
+                    node = used ;
+                    continue ;
+                }
+
+                Block* before = node->prev ;
+                Block* after = used->next ;
+                used->startaddress = node->startaddress ;
+                node->startaddress = used->startaddress + used->Size ;
+
+                used->prev = before ;
+                if( before != NULL ) before->next = used ;
+                else head = used ;
+                used->next = node ;
+                node->prev = used ;
+                node->next = after ;
+                if( after != NULL ) after->prev = node ;
+                moved += used->Size ;
+
+                if( after != NULL && after->flag == 1 ){
+                    node->Size += after->Size ;
+                    node->next = after->next ;
+                    if( after->next != NULL ) after->next->prev = node ;
+                    delete after ;
+                }
+                continue ;
+            }
+            node = node->next ;
         }
 
+        if( moved > 0 ) compactions++ ;
+        bytes_moved += moved ;
+        return moved ;
+    }
+
+    bool is_compacted(){
+        Block* node = head ;
+        while( node != NULL ){
+            if( node->flag == 1 && node->next != NULL ) return false ;
+            node = node->next ;
+        }
+        return true ;
     }
 
 
@@ -173,14 +319,14 @@ struct Memory{
     }
 
 
-    void free_memory( int id ){
+    bool free_memory( int id ){
         Block* node = head ;
         bool found = 0 ;
 
         while( node != NULL && found == 0 ){
             if( node->Id == id ){
                 found = 1 ;
-                cout << "Memory with ID " << id << " freed successfully" << endl ;
+                if( verbose ) cout << "Memory with ID " << id << " freed successfully" << endl ;
                 node->flag = 1 ;
                 Block* after = node->next ;
                 Block* before = node->prev ;
@@ -201,9 +347,10 @@ struct Memory{
             node = node->next ;
         }
 
-        if( found == 0 ){
+        if( found == 0 && verbose ){
             cout << "No memory block with Id: " << id << " found" << endl ;
         }
+        return found ;
 
     }
 
@@ -256,6 +403,16 @@ struct Memory{
         } else {
             cout << "Allocation Success Rate N/A" << endl ;
         }
+
+        // Compaction Statistics
+        cout << "Auto Compaction: " << ( auto_compact ? "on" : "off" ) << endl ;
+        cout << "Compactions: " << compactions << ", Units Moved: " << bytes_moved << endl ;
+        cout << "Allocations Rescued by Compaction: " << compaction_rescues << endl ;
+        cout << "Failures Recoverable by Compaction: " << recoverable_failures << endl ;
+        if( total_allocations > 0 ){
+            double potential_rate = ((double)( successful_allocations + recoverable_failures ) / total_allocations) * 100 ;
+            cout << "Success Rate with Compaction " << potential_rate << "%" << endl ;
+        }
     
     }
 
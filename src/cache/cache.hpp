@@ -4,8 +4,11 @@
 #include <iostream>
 #include <vector>
 #include <deque>
+#include <set>
+#include <string>
 #include "../allocator/memory.hpp"
 #include <cmath>
+#include <algorithm>
 using namespace std;
 
 
@@ -14,6 +17,7 @@ struct cacheline{
 
     int tag ;
     int data ;
+    bool prefetched = false ;
 
     cacheline( int t , int d ){
         tag = t ;
@@ -22,6 +26,15 @@ struct cacheline{
 
 };
 
+// One tracked sequential stream of a stream-buffer prefetcher: blocks
+// next..ahead have been prefetched and are waiting for demand.
+struct prefetch_stream{
+
+    int next ;
+    int ahead ;
+
+};
+
 struct cachelevel{
 
     int Size ;
@@ -31,6 +44,25 @@ struct cachelevel{
     int hits = 0 ;
     int misses = 0 ;
 
+    // Prefetcher: 0 none, 1 next-line, 2 stride, 3 stream buffer
+    int prefetcher = 0 ;
+    int prefetch_degree = 1 ;
+    int prefetch_delay = 1 ;    // demand accesses before a prefetch lands
+
+    int prefetch_fills = 0 ;
+    int useful_prefetches = 0 ;
+    int late_prefetches = 0 ;
+    int pollution_evictions = 0 ;
+
+    int clock = 0 ;
+    deque < pair < int , int > > pending ;      // (block address, ready clock)
+    set < int > prefetch_victims ;              // demand lines evicted by a prefetch fill
+    int last_block = -1 ;
+    int last_stride = 0 ;
+    int stride_confidence = 0 ;
+    deque < prefetch_stream > streams ;
+    int max_streams = 4 ;
+
     Memory* memory  ;
 
     int sets ;
@@ -39,6 +71,8 @@ struct cachelevel{
 
     
     vector < deque < cacheline > > cache ;
+    vector < int > set_hits ;
+    vector < int > set_misses ;
 
     cachelevel( int size , int bsize , int associ , Memory* mem ){
         
@@ -47,13 +81,15 @@ struct cachelevel{
         associativity = associ ;
         sets = ( Size  / ( associativity * Blocksize ) ) ;
         cache.resize( sets ) ;
+        set_hits.resize( sets ) ;
+        set_misses.resize( sets ) ;
         memory = mem ;
         offset_bits = log2( Blocksize ) ;
         set_bits = log2( sets ) ;
 
     }
 
-    void insert( int address ){
+    void insert( int address , bool prefetched = false ){
 
         int offset = ( address & ( ( 1 << offset_bits ) - 1 ) ) ;
         int set = (address >> offset_bits) & ( ( 1 << set_bits ) - 1) ;
@@ -61,11 +97,107 @@ struct cachelevel{
         int tag = address >> ( offset_bits + set_bits ) ;
 
         if( cache[ set ].size() == associativity ){
+            cacheline victim = cache[ set ].back() ;
+            if( prefetched && !victim.prefetched ){
+                prefetch_victims.insert( ( ( victim.tag << set_bits ) | set ) << offset_bits ) ;
+            }
             cache[ set ].pop_back() ;
         }
         cacheline to_insert( tag , 0 ) ;
+        to_insert.prefetched = prefetched ;
         cache[ set ].push_front(  to_insert ) ;
 
+        if( !prefetched ) prefetch_victims.erase( address & ~( Blocksize - 1 ) ) ;
+
+    }
+
+    bool contains( int address ){
+        int set = (address >> offset_bits) & ( ( 1 << set_bits ) - 1) ;
+        int tag = address >> ( offset_bits + set_bits ) ;
+        for( auto &line : cache[ set ] ){
+            if( line.tag == tag ) return true ;
+        }
+        return false ;
+    }
+
+    // Queue a prefetch of the block containing address; it is filled
+    // prefetch_delay demand accesses from now.
+    void issue_prefetch( int address ){
+        if( address < 0 ) return ;
+        int block = address & ~( Blocksize - 1 ) ;
+        if( contains( block ) ) return ;
+        for( auto &p : pending ){
+            if( p.first == block ) return ;
+        }
+        pending.push_back( { block , clock + prefetch_delay } ) ;
+    }
+
+    void land_prefetches(){
+        while( !pending.empty() && pending.front().second <= clock ){
+            int block = pending.front().first ;
+            pending.pop_front() ;
+            if( contains( block ) ) continue ;
+            insert( block , true ) ;
+            prefetch_fills++ ;
+        }
+    }
+
+    void train_prefetcher( int address , bool hit , bool prefetch_hit ){
+
+        int block = address / Blocksize ;
+
+        if( prefetcher == 1 ){
+            // Tagged next-line: trigger on misses and first use of a prefetched line
+            if( !hit || prefetch_hit ){
+                for( int i = 1 ; i <= prefetch_degree ; i++ ) issue_prefetch( ( block + i ) * Blocksize ) ;
+            }
+        }
+
+        if( prefetcher == 2 ){
+            // IP-less stride detector over the global block address stream
+            if( last_block != -1 && block != last_block ){
+                int stride = block - last_block ;
+                if( stride == last_stride ){
+                    if( stride_confidence < 2 ) stride_confidence++ ;
+                }
+                else{
+                    stride_confidence = 0 ;
+                    last_stride = stride ;
+                }
+                if( stride_confidence >= 1 ){
+                    for( int i = 1 ; i <= prefetch_degree ; i++ ) issue_prefetch( ( block + stride * i ) * Blocksize ) ;
+                }
+            }
+            if( block != last_block ) last_block = block ;
+        }
+
+        if( prefetcher == 3 ){
+            // Stream buffers: a touch inside a stream's window advances it,
+            // a miss outside every window allocates a new stream (LRU replaced)
+            for( auto it = streams.begin() ; it != streams.end() ; it++ ){
+                if( block >= it->next && block <= it->ahead ){
+                    prefetch_stream stream = *it ;
+                    streams.erase( it ) ;
+                    stream.next = block + 1 ;
+                    while( stream.ahead < block + prefetch_degree ){
+                        stream.ahead++ ;
+                        issue_prefetch( stream.ahead * Blocksize ) ;
+                    }
+                    streams.push_front( stream ) ;
+                    return ;
+                }
+            }
+            if( !hit ){
+                if( (int)streams.size() == max_streams ) streams.pop_back() ;
+                prefetch_stream stream = { block + 1 , block } ;
+                while( stream.ahead < block + prefetch_degree ){
+                    stream.ahead++ ;
+                    issue_prefetch( stream.ahead * Blocksize ) ;
+                }
+                streams.push_front( stream ) ;
+            }
+        }
+
     }
 
 
@@ -75,10 +207,14 @@ struct cachelevel{
 
         int tag = address >> ( offset_bits + set_bits ) ;
         bool found = 0 ;
+        bool prefetch_hit = 0 ;
+        if( prefetcher != 0 ) land_prefetches() ;
         for (auto it = cache[set].begin(); it != cache[set].end(); ++it) 
         {
             if (it->tag == tag) {
                 cacheline hit_line = *it;
+                prefetch_hit = hit_line.prefetched ;
+                hit_line.prefetched = false ;
                 cache[set].erase(it);
                 cache[set].push_front(hit_line);
                 found = 1 ;
@@ -86,8 +222,32 @@ struct cachelevel{
             }
         }
 
-        if( found ) hits ++ ;
-        else misses ++ ;
+        if( found ){
+            hits ++ ;
+            set_hits[ set ]++ ;
+        }
+        else{
+            misses ++ ;
+            set_misses[ set ]++ ;
+        }
+
+        if( prefetcher != 0 ){
+            int block = address & ~( Blocksize - 1 ) ;
+            if( prefetch_hit ) useful_prefetches++ ;
+            if( !found ){
+                // Demand caught up with a prefetch still in flight
+                for( auto it = pending.begin() ; it != pending.end() ; it++ ){
+                    if( it->first == block ){
+                        late_prefetches++ ;
+                        pending.erase( it ) ;
+                        break ;
+                    }
+                }
+                if( prefetch_victims.erase( block ) ) pollution_evictions++ ;
+            }
+            train_prefetcher( address , found , prefetch_hit ) ;
+            clock++ ;
+        }
         return found ;
     }
 
@@ -107,12 +267,86 @@ struct cachelevel{
 
     }
 
+    string prefetcher_name(){
+        if( prefetcher == 1 ) return "next-line" ;
+        if( prefetcher == 2 ) return "stride" ;
+        if( prefetcher == 3 ) return "stream" ;
+        return "none" ;
+    }
+
+    // Fraction of prefetched lines that were demanded before eviction
+    double prefetch_accuracy(){
+        if( prefetch_fills == 0 ) return 0.0 ;
+        return ( double )useful_prefetches / prefetch_fills ;
+    }
+
+    // Fraction of would-be misses that prefetching turned into hits
+    double prefetch_coverage(){
+        if( useful_prefetches + misses == 0 ) return 0.0 ;
+        return ( double )useful_prefetches / ( useful_prefetches + misses ) ;
+    }
+
+    void prefetch_stats( string name ){
+        if( prefetcher == 0 ) return ;
+        cout << name << " Prefetcher: " << prefetcher_name() << " (degree " << prefetch_degree
+             << ", delay " << prefetch_delay << ") - Fills: " << prefetch_fills
+             << ", Useful: " << useful_prefetches << ", Late: " << late_prefetches
+             << ", Pollution: " << pollution_evictions << endl ;
+        cout << name << " Prefetch Accuracy: " << prefetch_accuracy()
+             << ", Coverage: " << prefetch_coverage() << endl ;
+    }
+
+    // Hit ratio estimated from a sample of sets, each set treated as a cluster
+    // (ratio estimator). half_width is the 95% confidence half-interval;
+    // fraction is the share of sets sampled, for the finite population correction.
+    double sampled_hit_ratio( double fraction , double &half_width ){
+
+        int n = 0 ;
+        double total_hits = 0 , total_accesses = 0 ;
+        for( int i = 0 ; i < sets ; i++ ){
+            int accesses = set_hits[ i ] + set_misses[ i ] ;
+            if( accesses == 0 ) continue ;
+            n++ ;
+            total_hits += set_hits[ i ] ;
+            total_accesses += accesses ;
+        }
+
+        half_width = 0 ;
+        if( n == 0 ) return 0.0 ;
+        double ratio = total_hits / total_accesses ;
+        if( n < 2 ) return ratio ;
+
+        double mean_accesses = total_accesses / n ;
+        double residuals = 0 ;
+        for( int i = 0 ; i < sets ; i++ ){
+            int accesses = set_hits[ i ] + set_misses[ i ] ;
+            if( accesses == 0 ) continue ;
+            double r = set_hits[ i ] - ratio * accesses ;
+            residuals += r * r ;
+        }
+        double variance = ( 1 - fraction ) * residuals / ( ( n - 1 ) * n * mean_accesses * mean_accesses ) ;
+        half_width = 1.96 * sqrt( variance ) ;
+        return ratio ;
+    }
+
     double hit_ratio(){
         if( hits + misses == 0 ) return 0.0 ;
         
         return ( double )hits / ( hits + misses ) ;
     }
 
+    // Clears the counters (not the contents) so a trace run reports on its own
+    void reset_stats(){
+        hits = 0 ;
+        misses = 0 ;
+        prefetch_fills = 0 ;
+        useful_prefetches = 0 ;
+        late_prefetches = 0 ;
+        pollution_evictions = 0 ;
+        fill( set_hits.begin() , set_hits.end() , 0 ) ;
+        fill( set_misses.begin() , set_misses.end() , 0 ) ;
+    }
+
 
 
 
@@ -0,0 +1,178 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <string>
+#include <algorithm>
+#include "../allocator/memory.hpp"
+using namespace std ;
+
+// NUMA model: physical memory is split into nodes laid out back to back in
+// the physical address space. Each node has its own Memory for malloc, and
+// page frames belong to the node whose address range they fall in.
+struct numa_topology{
+
+    int num_nodes ;
+    vector < int > capacity ;
+    vector < int > node_start ;
+    vector < vector < int > > distance ;    // SLIT style: 10 is local
+
+    // Placement policy: 0 first-touch, 1 interleave, 2 preferred, 3 bind
+    int policy = 0 ;
+    int preferred = 0 ;
+    vector < bool > allowed ;
+    int cpu_node = 0 ;          // node of the CPU issuing requests
+    int interleave_next = 0 ;
+    int migrate_threshold = 4 ; // consecutive remote accesses before migrating, 0 disables
+
+    vector < Memory* > node_memory ;
+    map < int , pair < int , int > > blocks ;  // global ID -> (node, node-local ID)
+    int Id = 0 ;
+
+    vector < int > allocations_on ;
+    int local_allocations = 0 ;
+    int remote_allocations = 0 ;
+    int failed_allocations = 0 ;
+
+    vector < int > frames_on ;  // filled in by the attached virtual memory
+    long long local_accesses = 0 ;
+    long long remote_accesses = 0 ;
+    long long distance_sum = 0 ;
+    int migrations = 0 ;
+
+    numa_topology( vector < int > caps ){
+        num_nodes = caps.size() ;
+        capacity = caps ;
+        int start = 0 ;
+        for( int i = 0 ; i < num_nodes ; i++ ){
+            node_start.push_back( start ) ;
+            start += capacity[ i ] ;
+            node_memory.push_back( new Memory( capacity[ i ] , false ) ) ;
+        }
+        distance.assign( num_nodes , vector < int >( num_nodes , 20 ) ) ;
+        for( int i = 0 ; i < num_nodes ; i++ ) distance[ i ][ i ] = 10 ;
+        allowed.assign( num_nodes , true ) ;
+        allocations_on.assign( num_nodes , 0 ) ;
+        frames_on.assign( num_nodes , 0 ) ;
+    }
+
+    string policy_name(){
+        if( policy == 1 ) return "interleave" ;
+        if( policy == 2 ) return "preferred" ;
+        if( policy == 3 ) return "bind" ;
+        return "first-touch" ;
+    }
+
+    int total_capacity(){
+        int total = 0 ;
+        for( int size : capacity ) total += size ;
+        return total ;
+    }
+
+    bool valid_node( int node ){
+        return node >= 0 && node < num_nodes ;
+    }
+
+    int node_of( int physical_address ){
+        for( int i = num_nodes - 1 ; i > 0 ; i-- ){
+            if( physical_address >= node_start[ i ] ) return i ;
+        }
+        return 0 ;
+    }
+
+    // Candidate nodes in the order a request should try them: the policy's
+    // target first, then by distance from it; bind drops disallowed nodes
+    vector < int > placement_order( int interleave_key ){
+
+        int target = cpu_node ;
+        if( policy == 1 ) target = interleave_key % num_nodes ;
+        if( policy == 2 ) target = preferred ;
+
+        vector < int > order ;
+        for( int i = 0 ; i < num_nodes ; i++ ){
+            if( policy != 3 || allowed[ i ] ) order.push_back( i ) ;
+        }
+        stable_sort( order.begin() , order.end() , [ & ]( int a , int b ){
+            return distance[ target ][ a ] < distance[ target ][ b ] ;
+        } ) ;
+        return order ;
+    }
+
+    int malloc_block( int size ){
+
+        for( int node : placement_order( interleave_next++ ) ){
+            int local_id = node_memory[ node ]->first_fit( size ) ;
+            if( local_id == -1 ) continue ;
+            Id++ ;
+            blocks[ Id ] = { node , local_id } ;
+            allocations_on[ node ]++ ;
+            if( node == cpu_node ) local_allocations++ ;
+            else remote_allocations++ ;
+            cout << "Memory allocated with ID: " << Id << " on node " << node << endl ;
+            return Id ;
+        }
+
+        failed_allocations++ ;
+        cout << "memory not available" << endl ;
+        return -1 ;
+    }
+
+    bool free_block( int id ){
+        if( blocks.count( id ) == 0 ){
+            cout << "No memory block with Id: " << id << " found" << endl ;
+            return false ;
+        }
+        node_memory[ blocks[ id ].first ]->free_memory( blocks[ id ].second ) ;
+        blocks.erase( id ) ;
+        cout << "Memory with ID " << id << " freed successfully" << endl ;
+        return true ;
+    }
+
+    void record_access( int node ){
+        if( node == cpu_node ) local_accesses++ ;
+        else remote_accesses++ ;
+        distance_sum += distance[ cpu_node ][ node ] ;
+    }
+
+    // Whether setting the a-b distance to d keeps every node's local distance
+    // no larger than its remote ones, so latency_factor never drops below 1
+    bool consistent_distance( int a , int b , int d ){
+        for( int j = 0 ; j < num_nodes ; j++ ){
+            if( a == b && j != a && d > distance[ a ][ j ] ) return false ;
+        }
+        return a == b || ( d >= distance[ a ][ a ] && d >= distance[ b ][ b ] ) ;
+    }
+
+    // Memory latency scale for an access from the current CPU to node
+    double latency_factor( int node ){
+        return ( double )distance[ cpu_node ][ node ] / distance[ cpu_node ][ cpu_node ] ;
+    }
+
+    void stats(){
+        cout << "NUMA Nodes: " << num_nodes << ", Policy: " << policy_name() ;
+        if( policy == 2 ) cout << " (node " << preferred << ")" ;
+        cout << ", CPU Node: " << cpu_node << endl ;
+        for( int i = 0 ; i < num_nodes ; i++ ){
+            cout << "Node " << i << " - Capacity: " << capacity[ i ] << ", Allocations: " << allocations_on[ i ]
+                 << ", Frames: " << frames_on[ i ] << ", Distances:" ;
+            for( int j = 0 ; j < num_nodes ; j++ ) cout << " " << distance[ i ][ j ] ;
+            cout << endl ;
+        }
+        cout << "Allocations - Local: " << local_allocations << ", Remote: " << remote_allocations
+             << ", Failed: " << failed_allocations << endl ;
+
+        long long accesses = local_accesses + remote_accesses ;
+        cout << "Memory Accesses - Local: " << local_accesses << ", Remote: " << remote_accesses ;
+        if( accesses > 0 ){
+            cout << ", Local Ratio: " << ( double )local_accesses / accesses
+                 << ", Average Distance: " << ( double )distance_sum / accesses ;
+        }
+        cout << endl ;
+        cout << "Page Migrations: " << migrations << endl ;
+    }
+
+};
+
+#endif // NUMA_HPP
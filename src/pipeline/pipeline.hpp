@@ -0,0 +1,168 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <iostream>
+#include <string>
+#include "../cache/cache.hpp"
+#include "../virtual memory/virtual.hpp"
+using namespace std ;
+
+// End-to-end access path: virtual address -> page table -> L1 -> L2 -> memory.
+// Each access is charged the latency of every level it touches, so the
+// running average is the measured average memory access time (AMAT).
+struct access_pipeline{
+
+    // Latencies in cycles
+    int l1_latency = 1 ;
+    int l2_latency = 10 ;
+    int memory_latency = 100 ;
+    int fault_latency = 10000 ;
+    int migrate_latency = 5000 ;    // copying a page to another NUMA node
+
+    long long accesses = 0 ;
+    long long total_cycles = 0 ;
+    int page_faults = 0 ;
+    int l1_hits = 0 ;
+    int l2_hits = 0 ;
+    int memory_accesses = 0 ;
+    int migrations = 0 ;
+
+    bool verbose = true ;
+
+    bool set_latency( string level , int cycles ){
+        if( level == "l1" ) l1_latency = cycles ;
+        else if( level == "l2" ) l2_latency = cycles ;
+        else if( level == "memory" ) memory_latency = cycles ;
+        else if( level == "fault" ) fault_latency = cycles ;
+        else if( level == "migrate" ) migrate_latency = cycles ;
+        else return false ;
+        return true ;
+    }
+
+    void flush_frame( cachelevel* level , int frame_base , int page_size ){
+        for( int address = frame_base ; address < frame_base + page_size ; address += level->Blocksize ){
+            level->cache_flush( address ) ;
+        }
+    }
+
+    // Refilled frames of the last page fault (several for a huge page) hold
+    // stale lines of their old pages
+    void flush_refilled( virtual_memory* vmem , cachelevel* l1 , cachelevel* l2 ){
+        for( int f_num : vmem->refilled ){
+            if( l1 != NULL ) flush_frame( l1 , f_num * vmem->page_size , vmem->page_size ) ;
+            if( l2 != NULL ) flush_frame( l2 , f_num * vmem->page_size , vmem->page_size ) ;
+        }
+    }
+
+    // Translates through vmem, adding the page-fault penalty to cycles
+    int translate( int virtual_address , virtual_memory* vmem , cachelevel* l1 , cachelevel* l2 , int &cycles ){
+
+        int faults_before = vmem->page_faults ;
+        int physical_address = vmem->translate( virtual_address ) ;
+        if( vmem->page_faults != faults_before ){
+            cycles += fault_latency ;
+            if( verbose ) cout << "Page fault on virtual address " << virtual_address << endl ;
+            flush_refilled( vmem , l1 , l2 ) ;
+        }
+        return physical_address ;
+    }
+
+    // Records a reference that reached memory on its NUMA node. If the page
+    // migrates as a result, the copy is charged and both frames are flushed:
+    // the old one still holds the page's lines, the new one may hold lines of
+    // an earlier occupant.
+    int numa_reference( int physical_address , virtual_memory* vmem , cachelevel* l1 , cachelevel* l2 ){
+        if( vmem == NULL || vmem->numa == NULL ) return 0 ;
+        if( !vmem->numa_access( physical_address ) ) return 0 ;
+        for( int f_num : vmem->migrated ){
+            if( l1 != NULL ) flush_frame( l1 , f_num * vmem->page_size , vmem->page_size ) ;
+            if( l2 != NULL ) flush_frame( l2 , f_num * vmem->page_size , vmem->page_size ) ;
+        }
+        if( verbose ) cout << "Page migrated from frame " << vmem->migrated[ 0 ] << " to frame " << vmem->migrated[ 1 ] << endl ;
+        return migrate_latency ;
+    }
+
+    // Reads a physical address through L1, L2 and memory. Returns the cycles
+    // spent and sets level to 1, 2 or 3 for where the data was found.
+    int cache_access( int physical_address , virtual_memory* vmem , cachelevel* l1 , cachelevel* l2 , int &level ){
+
+        int cycles = 0 ;
+        bool found_in_l1 = false ;
+        bool found_in_l2 = false ;
+
+        if( l1 != NULL ){
+            cycles += l1_latency ;
+            found_in_l1 = l1->read( physical_address ) ;
+        }
+
+        if( !found_in_l1 && l2 != NULL ){
+            cycles += l2_latency ;
+            found_in_l2 = l2->read( physical_address ) ;
+            if( found_in_l2 && l1 != NULL ) l1->insert( physical_address ) ;
+        }
+
+        if( found_in_l1 ){
+            level = 1 ;
+            if( verbose ) cout << "Found in L1 cache" << endl ;
+        }
+        else if( found_in_l2 ){
+            level = 2 ;
+            if( verbose ) cout << "Found in L2 cache" << endl ;
+        }
+        else{
+            level = 3 ;
+            numa_topology* numa = ( vmem != NULL ) ? vmem->numa : NULL ;
+            if( numa != NULL ) cycles += memory_latency * numa->latency_factor( numa->node_of( physical_address ) ) ;
+            else cycles += memory_latency ;
+            if( verbose ) cout << "Found in main memory" << endl ;
+            if( l1 != NULL ) l1->insert( physical_address ) ;
+            if( l2 != NULL ) l2->insert( physical_address ) ;
+            cycles += numa_reference( physical_address , vmem , l1 , l2 ) ;
+        }
+
+        return cycles ;
+    }
+
+    // Returns the cycles spent on this access
+    int access( int virtual_address , virtual_memory* vmem , cachelevel* l1 , cachelevel* l2 ){
+
+        int cycles = 0 ;
+        accesses++ ;
+
+        int faults_before = vmem->page_faults ;
+        int migrations_before = ( vmem->numa != NULL ) ? vmem->numa->migrations : 0 ;
+        int physical_address = translate( virtual_address , vmem , l1 , l2 , cycles ) ;
+        if( vmem->page_faults != faults_before ) page_faults++ ;
+        if( verbose ) cout << "Virtual address " << virtual_address << " -> Physical address " << physical_address << endl ;
+
+        int level ;
+        cycles += cache_access( physical_address , vmem , l1 , l2 , level ) ;
+        if( level == 1 ) l1_hits++ ;
+        else if( level == 2 ) l2_hits++ ;
+        else memory_accesses++ ;
+        if( vmem->numa != NULL ) migrations += vmem->numa->migrations - migrations_before ;
+
+        total_cycles += cycles ;
+        if( verbose ) cout << "Access cycles: " << cycles << endl ;
+        return cycles ;
+    }
+
+    double amat(){
+        if( accesses == 0 ) return 0.0 ;
+        return ( double )total_cycles / accesses ;
+    }
+
+    void stats(){
+        cout << "Latencies (cycles) - L1: " << l1_latency << ", L2: " << l2_latency
+             << ", Memory: " << memory_latency << ", Page Fault: " << fault_latency
+             << ", Page Migration: " << migrate_latency << endl ;
+        cout << "Accesses: " << accesses << ", Total Cycles: " << total_cycles << endl ;
+        cout << "L1 Hits: " << l1_hits << ", L2 Hits: " << l2_hits
+             << ", Memory Accesses: " << memory_accesses << ", Page Faults: " << page_faults
+             << ", Migrations: " << migrations << endl ;
+        cout << "AMAT: " << amat() << " cycles" << endl ;
+    }
+
+};
+
+#endif // PIPELINE_HPP
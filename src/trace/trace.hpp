@@ -0,0 +1,186 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <climits>
+#include "../cache/cache.hpp"
+#include "../virtual memory/virtual.hpp"
+#include "../pipeline/pipeline.hpp"
+using namespace std ;
+
+// Streams a memory trace from disk one line at a time into the virtual
+// memory and cache models. Two formats are recognised per line:
+//   Valgrind Lackey:  "I  0400d7d4,8"  " L 1ffefffd68,8"  " S ..."  " M ..."
+//   Simple CSV:       "R,0x7ffd1000,8"  or  "W 4096 4"
+// Trace addresses are 64-bit; they are folded into the simulator's address
+// space (modulo the virtual memory size, or the low 31 bits without one).
+struct trace_importer{
+
+    bool data_only = false ;    // skip Lackey instruction fetches
+    int sample_stride = 1 ;     // simulate only cache sets whose index is a multiple of this
+
+    long long lines = 0 ;
+    long long skipped = 0 ;
+    long long loads = 0 ;
+    long long stores = 0 ;
+    long long modifies = 0 ;
+    long long fetches = 0 ;
+    long long references = 0 ;  // a modify is a load and a store
+    long long page_faults = 0 ;
+    long long cache_refs = 0 ;  // cache blocks touched by all references
+    long long sampled = 0 ;     // cache blocks actually simulated
+    long long l1_hits = 0 ;
+    long long l2_hits = 0 ;
+    long long l2_lookups = 0 ;
+    long long fault_cycles = 0 ;
+    long long cache_cycles = 0 ;
+
+    bool parse( string line , char &kind , long long &address , int &size ){
+
+        if( line.empty() || line[ 0 ] == '#' || line[ 0 ] == '=' ) return false ;
+        for( char &c : line ){
+            if( c == ',' ) c = ' ' ;
+        }
+        stringstream in( line ) ;
+        string type , addr ;
+        size = 1 ;
+        if( !( in >> type >> addr ) || type.size() != 1 ) return false ;
+        in >> size ;
+
+        kind = type[ 0 ] ;
+        try{
+            if( kind == 'I' || kind == 'L' || kind == 'S' || kind == 'M' ) address = stoll( addr , NULL , 16 ) ;
+            else if( kind == 'R' || kind == 'W' ){
+                bool hex = addr.size() > 2 && addr[ 0 ] == '0' && ( addr[ 1 ] == 'x' || addr[ 1 ] == 'X' ) ;
+                address = stoll( addr , NULL , hex ? 16 : 10 ) ;
+            }
+            else return false ;
+        }
+        catch( ... ){
+            return false ;
+        }
+        return address >= 0 ;
+    }
+
+    void reference( long long address , int size , virtual_memory* vmem , cachelevel* l1 , cachelevel* l2 , access_pipeline &pipeline ){
+
+        references++ ;
+        int physical_address ;
+        if( vmem != NULL ){
+            int cycles = 0 ;
+            int faults_before = vmem->page_faults ;
+            physical_address = pipeline.translate( (int)( address % vmem->vmem_size ) , vmem , l1 , l2 , cycles ) ;
+            if( vmem->page_faults != faults_before ) page_faults++ ;
+            fault_cycles += cycles ;
+        }
+        else{
+            physical_address = (int)( address & INT_MAX ) ;
+        }
+
+        cachelevel* first_level = ( l1 != NULL ) ? l1 : l2 ;
+        if( first_level == NULL ){
+            // No caches: every reference reaches memory
+            pipeline.numa_reference( physical_address , vmem , NULL , NULL ) ;
+            return ;
+        }
+
+        // An access straddling a line boundary touches both lines
+        int block_size = first_level->Blocksize ;
+        long long first = physical_address / block_size ;
+        long long last = ( (long long)physical_address + max( size , 1 ) - 1 ) / block_size ;
+        for( long long block = first ; block <= last ; block++ ){
+            cache_refs++ ;
+            if( block % sample_stride != 0 ) continue ;
+            sampled++ ;
+            int level ;
+            cache_cycles += pipeline.cache_access( (int)( block * block_size ) , vmem , l1 , l2 , level ) ;
+            if( level == 1 ) l1_hits++ ;
+            if( l2 != NULL && ( l1 == NULL || level != 1 ) ){
+                l2_lookups++ ;
+                if( level == 2 ) l2_hits++ ;
+            }
+        }
+    }
+
+    bool run( string file , virtual_memory* vmem , cachelevel* l1 , cachelevel* l2 , access_pipeline &pipeline ){
+
+        ifstream in( file ) ;
+        if( !in ) return false ;
+
+        bool verbose = pipeline.verbose ;
+        pipeline.verbose = false ;
+        if( l1 != NULL ) l1->reset_stats() ;
+        if( l2 != NULL ) l2->reset_stats() ;
+
+        string line ;
+        while( getline( in , line ) ){
+            lines++ ;
+            char kind ;
+            long long address ;
+            int size ;
+            if( !parse( line , kind , address , size ) ){
+                skipped++ ;
+                continue ;
+            }
+            if( kind == 'I' ){
+                if( data_only ) continue ;
+                fetches++ ;
+            }
+            if( kind == 'L' || kind == 'R' ) loads++ ;
+            if( kind == 'S' || kind == 'W' ) stores++ ;
+            if( kind == 'M' ){
+                modifies++ ;
+                reference( address , size , vmem , l1 , l2 , pipeline ) ;
+            }
+            reference( address , size , vmem , l1 , l2 , pipeline ) ;
+        }
+
+        pipeline.verbose = verbose ;
+        return true ;
+    }
+
+    void level_report( string name , cachelevel* level , long long hits , long long lookups , double fraction ){
+        if( level == NULL ) return ;
+        if( sample_stride == 1 ){
+            double ratio = ( lookups > 0 ) ? ( double )hits / lookups : 0.0 ;
+            cout << name << " Hit Ratio: " << ratio << " (" << hits << "/" << lookups << ")" << endl ;
+            return ;
+        }
+        double half_width ;
+        double ratio = level->sampled_hit_ratio( fraction , half_width ) ;
+        cout << name << " Hit Ratio (estimated): " << ratio << " +/- " << half_width << " (95% CI), "
+             << "sampled " << hits << "/" << lookups << endl ;
+    }
+
+    void report( string file , virtual_memory* vmem , cachelevel* l1 , cachelevel* l2 ){
+
+        cout << "Trace: " << file << ", Lines: " << lines << ", References: " << references
+             << " (Loads: " << loads << ", Stores: " << stores << ", Modifies: " << modifies
+             << ", Fetches: " << fetches << "), Skipped lines: " << skipped << endl ;
+        if( vmem != NULL ){
+            cout << "Page Faults: " << page_faults << ", Fault Rate: "
+                 << ( ( references > 0 ) ? ( double )page_faults / references : 0.0 ) << endl ;
+        }
+        if( l1 == NULL && l2 == NULL ) return ;
+
+        double fraction = 1.0 / sample_stride ;
+        cout << "Cache Blocks Referenced: " << cache_refs << ", Simulated: " << sampled ;
+        if( sample_stride > 1 ) cout << " (1/" << sample_stride << " of sets)" ;
+        cout << endl ;
+        level_report( "L1" , l1 , l1_hits , sampled , fraction ) ;
+        level_report( "L2" , l2 , l2_hits , l2_lookups , fraction ) ;
+
+        // Sampled cache cycles stand in for every block the trace touched
+        if( references > 0 && sampled > 0 ){
+            double per_block = ( double )cache_cycles / sampled ;
+            double amat = ( fault_cycles + per_block * cache_refs ) / references ;
+            cout << "AMAT" << ( sample_stride > 1 ? " (estimated)" : "" ) << ": " << amat << " cycles" << endl ;
+        }
+    }
+
+};
+
+#endif // TRACE_HPP
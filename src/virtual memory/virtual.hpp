@@ -4,7 +4,13 @@
 #include <iostream>
 #include <vector>
 #include <deque>
+#include <set>
+#include <string>
+#include <climits>
+#include <map>
+#include <algorithm>
 #include "../cache/cache.hpp"
+#include "../numa/numa.hpp"
 using namespace std ;
 
 struct PageTableEntry
@@ -12,6 +18,7 @@ struct PageTableEntry
     int frame_num = -1 ;
     bool valid = false ;
     int last_allocated = -1 ;
+    int span = 1 ;      // base pages covered by the mapping this entry belongs to
 };
 
 struct frame{
@@ -20,6 +27,11 @@ struct frame{
     int page_num = -1 ;
     int data ;
 
+    // Replacement bookkeeping
+    bool referenced = 0 ;
+    int last_use = 0 ;
+    unsigned int age = 0 ;
+
 };
 
 class PageTable{
@@ -47,11 +59,50 @@ struct virtual_memory{
 
     int pmem_size ;
     int num_frames ;
+
+    int page_faults = 0 ;
+    int translations = 0 ;
+
+    // Replacement policy: 0 LRU, 1 FIFO, 2 CLOCK, 3 second-chance,
+    // 4 WSClock, 5 aging, 6 OPT (replay traces only)
+    int policy = 0 ;
+    int vtime = 0 ;
+    int clock_hand = 0 ;
+    int working_set_window = 16 ;   // WSClock: accesses a page stays in the working set
+    int aging_interval = 4 ;        // aging: accesses between counter shifts
     
     PageTable page_table ; 
     deque < int > lru_queue ;
+    deque < int > fifo_queue ;
     vector < frame > ram ;
 
+    // OPT: page_uses[vpn] lists the trace positions that access vpn, so any
+    // page's next use is known, including pages prefilled by a huge mapping;
+    // resident frames are ordered by their next use
+    vector < vector < int > > page_uses ;
+    int trace_pos = 0 ;
+    set < pair < int , int > > opt_queue ;
+    vector < int > opt_key ;
+
+    // Huge pages: spans in base pages, largest first. A huge page maps an
+    // aligned region of base pages onto an equally aligned run of frames.
+    vector < int > huge_spans ;
+    int thp_mode = 0 ;              // 0 never, 1 promote dense regions, 2 also map huge on fault
+    int promote_threshold = 75 ;    // percent of a region resident before promotion
+    map < int , int > faults_by_span ;
+    map < int , int > promotions_by_span ;
+    map < int , int > demotions_by_span ;
+    int pages_migrated = 0 ;
+    int pages_prefilled = 0 ;
+    vector < int > refilled ;       // frames loaded by the last page fault
+
+    // NUMA: frames belong to nodes by physical address; pages that keep being
+    // accessed from one remote node migrate there
+    numa_topology* numa = NULL ;
+    vector < int > remote_streak ;
+    vector < int > streak_node ;
+    vector < int > migrated ;       // source and target frame of the last migration
+
     virtual_memory( int vmem , int pmem , int page )
     : page_table(vmem, page)
     {
@@ -60,6 +111,45 @@ struct virtual_memory{
         page_size = page ;
         num_frames = pmem_size / page_size ;
         ram.resize( num_frames ) ;
+        opt_key.resize( num_frames , INT_MAX ) ;
+    }
+
+    string policy_name(){
+        if( policy == 1 ) return "fifo" ;
+        if( policy == 2 ) return "clock" ;
+        if( policy == 3 ) return "second-chance" ;
+        if( policy == 4 ) return "wsclock" ;
+        if( policy == 5 ) return "aging" ;
+        if( policy == 6 ) return "opt" ;
+        return "lru" ;
+    }
+
+    // Switching policies rebuilds the queues from the resident frames; the
+    // LRU queue is ordered by last use, which every policy keeps up to date
+    void set_policy( int p ){
+        policy = p ;
+        lru_queue.clear() ;
+        fifo_queue.clear() ;
+        opt_queue.clear() ;
+        for( int i = 0 ; i < num_frames ; i++ ){
+            if( ram[ i ].occupied == 0 ) continue ;
+            ram[ i ].referenced = 0 ;
+            ram[ i ].age = 0 ;
+            lru_queue.push_back( i ) ;
+            fifo_queue.push_back( i ) ;
+        }
+        stable_sort( lru_queue.begin() , lru_queue.end() , [ & ]( int a , int b ){
+            return ram[ a ].last_use < ram[ b ].last_use ;
+        } ) ;
+    }
+
+    // Precompute the per-page access positions for an offline replay under OPT
+    void load_trace( vector < int > &addresses ){
+        page_uses.assign( page_table.num_pages , vector < int >() ) ;
+        for( int i = 0 ; i < (int)addresses.size() ; i++ ){
+            page_uses[ addresses[ i ] / page_size ].push_back( i ) ;
+        }
+        trace_pos = 0 ;
     }
 
     int translate(int virtual_address) {
@@ -68,20 +158,35 @@ struct virtual_memory{
         // vpn -> virtual page number
         int offset = virtual_address % page_size ;
 
+        translations++ ;
+        vtime++ ;
+        if( policy == 5 && vtime % aging_interval == 0 ) age_frames() ;
+
         if (!page_table.table[vpn].valid) {
-            return handle_page_fault( vpn , offset ) ; 
+            int physical_address = handle_page_fault( vpn , offset ) ; 
+            if( policy == 6 ) trace_pos++ ;
+            return physical_address ;
         }
 
         int f_num = page_table.table[vpn].frame_num ;
+        touch( f_num ) ;
 
-        for( auto it = lru_queue.begin() ; it != lru_queue.end() ; it++ ){
-            
-            if( *it == f_num ){
-                lru_queue.erase( it );
-                lru_queue.push_back( f_num ) ;
-                break; 
-            }
+        if( policy == 0 ){
+            for( auto it = lru_queue.begin() ; it != lru_queue.end() ; it++ ){
+                
+                if( *it == f_num ){
+                    lru_queue.erase( it );
+                    lru_queue.push_back( f_num ) ;
+                    break; 
+                }
 
+            }
+        }
+        if( policy == 6 ){
+            opt_queue.erase( { opt_key[ f_num ] , f_num } ) ;
+            opt_key[ f_num ] = next_use_of( vpn ) ;
+            opt_queue.insert( { opt_key[ f_num ] , f_num } ) ;
+            trace_pos++ ;
         }
         
 
@@ -89,41 +194,393 @@ struct virtual_memory{
 
     } 
 
+    void touch( int f_num ){
+        ram[ f_num ].referenced = 1 ;
+        ram[ f_num ].last_use = vtime ;
+    }
+
+    // First trace position after the current one that accesses vpn
+    int next_use_of( int vpn ){
+        if( vpn >= (int)page_uses.size() ) return INT_MAX ;
+        auto it = upper_bound( page_uses[ vpn ].begin() , page_uses[ vpn ].end() , trace_pos ) ;
+        return ( it == page_uses[ vpn ].end() ) ? INT_MAX : *it ;
+    }
+
+    void age_frames(){
+        for( int i = 0 ; i < num_frames ; i++ ){
+            if( ram[ i ].occupied == 0 ) continue ;
+            ram[ i ].age = ( ram[ i ].age >> 1 ) | ( ram[ i ].referenced ? 0x80 : 0 ) ;
+            ram[ i ].referenced = 0 ;
+        }
+    }
+
+    int choose_victim(){
+
+        if( policy == 1 ){
+            int victim = fifo_queue.front() ;
+            fifo_queue.pop_front() ;
+            return victim ;
+        }
+
+        if( policy == 2 ){
+            while( true ){
+                int current = clock_hand ;
+                clock_hand = ( clock_hand + 1 ) % num_frames ;
+                if( ram[ current ].referenced == 0 ) return current ;
+                ram[ current ].referenced = 0 ;
+            }
+        }
+
+        if( policy == 3 ){
+            while( true ){
+                int current = fifo_queue.front() ;
+                fifo_queue.pop_front() ;
+                if( ram[ current ].referenced == 0 ) return current ;
+                ram[ current ].referenced = 0 ;
+                fifo_queue.push_back( current ) ;
+            }
+        }
+
+        if( policy == 4 ){
+            // Evict the first unreferenced page outside the working set; if a
+            // full sweep finds none, fall back to the least recently used one
+            int oldest = -1 ;
+            for( int i = 0 ; i < num_frames ; i++ ){
+                int current = clock_hand ;
+                clock_hand = ( clock_hand + 1 ) % num_frames ;
+                if( ram[ current ].referenced ){
+                    ram[ current ].referenced = 0 ;
+                }
+                else if( vtime - ram[ current ].last_use > working_set_window ){
+                    return current ;
+                }
+                if( oldest == -1 || ram[ current ].last_use < ram[ oldest ].last_use ) oldest = current ;
+            }
+            return oldest ;
+        }
+
+        if( policy == 5 ){
+            // Smallest counter; ties go to pages not referenced since the last shift
+            int victim = 0 ;
+            for( int i = 1 ; i < num_frames ; i++ ){
+                if( ram[ i ].age < ram[ victim ].age ||
+                    ( ram[ i ].age == ram[ victim ].age && ram[ i ].referenced < ram[ victim ].referenced ) ) victim = i ;
+            }
+            return victim ;
+        }
+
+        if( policy == 6 ){
+            // Farthest next use, O(log n)
+            int victim = prev( opt_queue.end() )->second ;
+            opt_queue.erase( prev( opt_queue.end() ) ) ;
+            return victim ;
+        }
+
+        int victim = lru_queue.front() ;
+        lru_queue.pop_front() ;
+        return victim ;
+    }
+
     int handle_page_fault( int vpn , int offset ){
 
+        page_faults++ ;
+        refilled.clear() ;
+
+        if( thp_mode == 2 ){
+            for( int span : huge_spans ){
+                if( map_huge( vpn , span ) ){
+                    faults_by_span[ span ]++ ;
+                    return page_table.table[ vpn ].frame_num * page_size + offset ;
+                }
+            }
+        }
+        faults_by_span[ 1 ]++ ;
+
         bool empty_frame = 0 ;
 
         int target_frame = -1 ;
 
 
-        for( int i = 0 ; i < num_frames ; i++ ){
-            if( ram [ i ].occupied == 0 ){
-                target_frame = i ;
-                empty_frame = 1 ;
+        if( numa != NULL ){
+            target_frame = numa_frame( vpn ) ;
+            empty_frame = ( target_frame != -1 ) ;
+        }
+        else{
+            for( int i = 0 ; i < num_frames ; i++ ){
+                if( ram [ i ].occupied == 0 ){
+                    target_frame = i ;
+                    empty_frame = 1 ;
+                }
             }
         }
 
         if( !empty_frame ){
 
-            target_frame = lru_queue.front() ;
-            lru_queue.pop_front() ;
+            target_frame = choose_victim() ;
 
             int target_frame_page_num = ram[ target_frame ].page_num ;
+            if( page_table.table[ target_frame_page_num ].span > 1 ) demote( target_frame_page_num ) ;
             page_table.table[ target_frame_page_num ].frame_num = -1 ;
             page_table.table[ target_frame_page_num ].valid = false ;
 
 
         }
 
-        ram[ target_frame ].occupied = 1 ;
-        ram[ target_frame ].page_num = vpn ;
+        load_frame( target_frame , vpn ) ;
+        if( thp_mode != 0 ) promote( vpn ) ;
+
+        return page_table.table[ vpn ].frame_num * page_size + offset ;
+    }
+
+    void load_frame( int f_num , int vpn ){
+
+        ram[ f_num ].occupied = 1 ;
+        ram[ f_num ].page_num = vpn ;
+        ram[ f_num ].age = 0 ;
+        touch( f_num ) ;
 
-        page_table.table[ vpn ].frame_num = target_frame ;
+        page_table.table[ vpn ].frame_num = f_num ;
         page_table.table[ vpn ].valid = true ;
+        page_table.table[ vpn ].span = 1 ;
+
+        if( policy == 0 ) lru_queue.push_back( f_num ) ;
+        if( policy == 1 || policy == 3 ) fifo_queue.push_back( f_num ) ;
+        if( policy == 6 ){
+            opt_key[ f_num ] = next_use_of( vpn ) ;
+            opt_queue.insert( { opt_key[ f_num ] , f_num } ) ;
+        }
+        refilled.push_back( f_num ) ;
+    }
+
+    // Unmap a resident page without going through the replacement policy
+    void release_frame( int f_num ){
+
+        int vpn = ram[ f_num ].page_num ;
+        page_table.table[ vpn ].frame_num = -1 ;
+        page_table.table[ vpn ].valid = false ;
+        page_table.table[ vpn ].span = 1 ;
+        ram[ f_num ].occupied = 0 ;
+        ram[ f_num ].page_num = -1 ;
 
-        lru_queue.push_back( target_frame ) ;
+        lru_queue.erase( remove( lru_queue.begin() , lru_queue.end() , f_num ) , lru_queue.end() ) ;
+        fifo_queue.erase( remove( fifo_queue.begin() , fifo_queue.end() , f_num ) , fifo_queue.end() ) ;
+        opt_queue.erase( { opt_key[ f_num ] , f_num } ) ;
+    }
+
+    // Mappings of a span that is no longer configured are split into base pages
+    void set_huge_pages( vector < int > sizes ){
+        huge_spans.clear() ;
+        for( int size : sizes ) huge_spans.push_back( size / page_size ) ;
+        sort( huge_spans.rbegin() , huge_spans.rend() ) ;
+
+        for( int i = 0 ; i < num_frames ; i++ ){
+            if( ram[ i ].occupied == 0 ) continue ;
+            int span = page_table.table[ ram[ i ].page_num ].span ;
+            if( span > 1 && find( huge_spans.begin() , huge_spans.end() , span ) == huge_spans.end() ) demote( ram[ i ].page_num ) ;
+        }
+    }
+
+    // Map the aligned region around vpn as one huge page. Needs an aligned run
+    // of frames that are free or already hold pages of the same region; those
+    // pages are migrated into place and the rest of the region is filled.
+    // With NUMA the run must lie on one node, tried in placement order.
+    bool map_huge( int vpn , int span ){
+
+        int region = vpn - vpn % span ;
+        if( region + span > page_table.num_pages ) return false ;
+
+        vector < int > starts ;
+        for( int start = 0 ; start + span <= num_frames ; start += span ) starts.push_back( start ) ;
+        if( numa != NULL ){
+            vector < int > candidates = starts ;
+            starts.clear() ;
+            for( int node : numa->placement_order( region ) ){
+                for( int start : candidates ){
+                    if( numa->node_of( start * page_size ) == node &&
+                        numa->node_of( ( start + span ) * page_size - 1 ) == node ) starts.push_back( start ) ;
+                }
+            }
+        }
+
+        for( int start : starts ){
+
+            bool usable = true ;
+            for( int f = start ; f < start + span && usable ; f++ ){
+                int owner = ram[ f ].page_num ;
+                if( ram[ f ].occupied && ( owner < region || owner >= region + span ) ) usable = false ;
+            }
+            if( !usable ) continue ;
+
+            vector < int > old_frame( span , -1 ) ;
+            for( int i = 0 ; i < span ; i++ ){
+                if( page_table.table[ region + i ].valid ){
+                    old_frame[ i ] = page_table.table[ region + i ].frame_num ;
+                    release_frame( old_frame[ i ] ) ;
+                }
+            }
+            for( int i = 0 ; i < span ; i++ ){
+                load_frame( start + i , region + i ) ;
+                page_table.table[ region + i ].span = span ;
+                if( old_frame[ i ] == -1 ) pages_prefilled++ ;
+                else if( old_frame[ i ] != start + i ) pages_migrated++ ;
+            }
+            return true ;
+        }
+
+        return false ;
+    }
+
+    // Promote the largest dense region around vpn that is not yet huge
+    void promote( int vpn ){
+
+        for( int span : huge_spans ){
+            int region = vpn - vpn % span ;
+            if( region + span > page_table.num_pages ) continue ;
+            if( page_table.table[ region ].valid && page_table.table[ region ].span >= span ) return ;
+
+            int resident = 0 ;
+            for( int i = 0 ; i < span ; i++ ){
+                if( page_table.table[ region + i ].valid ) resident++ ;
+            }
+            if( resident * 100 < promote_threshold * span ) continue ;
+
+            if( map_huge( vpn , span ) ){
+                promotions_by_span[ span ]++ ;
+                return ;
+            }
+        }
+
+    }
+
+    // Split a huge page back into base pages
+    void demote( int vpn ){
+        int span = page_table.table[ vpn ].span ;
+        int region = vpn - vpn % span ;
+        for( int i = 0 ; i < span ; i++ ) page_table.table[ region + i ].span = 1 ;
+        demotions_by_span[ span ]++ ;
+    }
+
+    void attach_numa( numa_topology* topology ){
+        numa = topology ;
+        remote_streak.assign( page_table.num_pages , 0 ) ;
+        streak_node.assign( page_table.num_pages , -1 ) ;
+    }
+
+    int free_frame_on( int node ){
+        for( int i = 0 ; i < num_frames ; i++ ){
+            if( ram[ i ].occupied == 0 && numa->node_of( i * page_size ) == node ) return i ;
+        }
+        return -1 ;
+    }
+
+    // Free frame for vpn following the NUMA placement policy. Under bind, a
+    // full set of allowed nodes gives up its least recently used page rather
+    // than letting the replacement policy pick a frame on another node.
+    int numa_frame( int vpn ){
+
+        vector < int > order = numa->placement_order( vpn ) ;
+        for( int node : order ){
+            int f_num = free_frame_on( node ) ;
+            if( f_num != -1 ) return f_num ;
+        }
+        if( numa->policy != 3 ) return -1 ;
+
+        int victim = -1 ;
+        for( int i = 0 ; i < num_frames ; i++ ){
+            if( !numa->allowed[ numa->node_of( i * page_size ) ] ) continue ;
+            if( victim == -1 || ram[ i ].last_use < ram[ victim ].last_use ) victim = i ;
+        }
+        if( victim == -1 ) return -1 ;
+        if( page_table.table[ ram[ victim ].page_num ].span > 1 ) demote( ram[ victim ].page_num ) ;
+        release_frame( victim ) ;
+        return victim ;
+    }
+
+    // Called for each reference that reaches memory (not for cache hits).
+    // Returns true if the page migrated; migrated then holds both frames.
+    bool numa_access( int physical_address ){
+
+        migrated.clear() ;
+        int f_num = physical_address / page_size ;
+        if( f_num < 0 || f_num >= num_frames || ram[ f_num ].occupied == 0 ) return false ;
+        int vpn = ram[ f_num ].page_num ;
+        int node = numa->node_of( physical_address ) ;
+        numa->record_access( node ) ;
+
+        int cpu = numa->cpu_node ;
+        if( node == cpu || numa->migrate_threshold == 0 || page_table.table[ vpn ].span > 1 ){
+            remote_streak[ vpn ] = 0 ;
+            return false ;
+        }
+        if( streak_node[ vpn ] == cpu ) remote_streak[ vpn ]++ ;
+        else{
+            streak_node[ vpn ] = cpu ;
+            remote_streak[ vpn ] = 1 ;
+        }
+        if( remote_streak[ vpn ] < numa->migrate_threshold ) return false ;
+        if( numa->policy == 3 && !numa->allowed[ cpu ] ) return false ;
+
+        // Migrate only into a free frame; a full node keeps the page remote
+        int target = free_frame_on( cpu ) ;
+        if( target == -1 ) return false ;
+        release_frame( f_num ) ;
+        load_frame( target , vpn ) ;
+        remote_streak[ vpn ] = 0 ;
+        numa->migrations++ ;
+        migrated = { f_num , target } ;
+        return true ;
+    }
+
+    void count_numa_frames(){
+        numa->frames_on.assign( numa->num_nodes , 0 ) ;
+        for( int i = 0 ; i < num_frames ; i++ ){
+            if( ram[ i ].occupied ) numa->frames_on[ numa->node_of( i * page_size ) ]++ ;
+        }
+    }
+
+    // Huge page sizes configured now or used at some point
+    vector < int > spans_seen(){
+        set < int > seen( huge_spans.begin() , huge_spans.end() ) ;
+        for( auto &entry : faults_by_span ) if( entry.first > 1 && entry.second > 0 ) seen.insert( entry.first ) ;
+        for( auto &entry : promotions_by_span ) if( entry.second > 0 ) seen.insert( entry.first ) ;
+        for( auto &entry : demotions_by_span ) if( entry.second > 0 ) seen.insert( entry.first ) ;
+        return vector < int >( seen.rbegin() , seen.rend() ) ;
+    }
+
+    void page_size_stats(){
+
+        vector < int > spans = spans_seen() ;
+        spans.push_back( 1 ) ;
+
+        int entries = 0 ;
+        int resident = 0 ;
+        for( int span : spans ){
+            int frames_used = 0 ;
+            for( int i = 0 ; i < num_frames ; i++ ){
+                if( ram[ i ].occupied && page_table.table[ ram[ i ].page_num ].span == span ) frames_used++ ;
+            }
+            int mappings = frames_used / span ;
+            entries += mappings ;
+            resident += frames_used ;
+
+            cout << "Page size " << span * page_size << " - Faults: " << faults_by_span[ span ]
+                 << ", Mappings: " << mappings << ", Frames: " << frames_used ;
+            if( span > 1 ){
+                cout << ", Promotions: " << promotions_by_span[ span ] << ", Demotions: " << demotions_by_span[ span ] ;
+            }
+            cout << endl ;
+        }
+
+        // No TLB is modelled; the number of translations needed to cover the
+        // resident set stands in for TLB reach
+        cout << "Translation entries for resident memory: " << entries << " (" << resident << " with base pages only)" << endl ;
+        if( entries > 0 ) cout << "Average reach per entry: " << ( resident * page_size ) / entries << endl ;
+        cout << "Pages migrated: " << pages_migrated << ", Pages prefilled: " << pages_prefilled << endl ;
+    }
 
-        return target_frame * page_size + offset ;
+    double fault_rate(){
+        if( translations == 0 ) return 0.0 ;
+        return ( double )page_faults / translations ;
     }
 
     